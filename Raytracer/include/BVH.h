@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/Object.h"
+
+// Deepest a leaf can be, matches BVH_STACK_SIZE in raytracing_common.glsl
+#define BVH_MAX_DEPTH 32
+// Largest growth of the node areas Refit allows before the tree has to be built again, see BVH::GetGrowth
+#define BVH_REFIT_GROWTH_LIMIT 1.25f
+
+// Also the std430 layout of BVHNode in raytracing_common.glsl.
+// Nodes are stored depth first so the left child of an interior node is always the next node
+struct BVHNode {
+    glm::vec3 bounds_min;
+    int right_or_first; // interior: index of the right child, leaf: first entry in the primitive indices
+    glm::vec3 bounds_max;
+    int count;          // number of primitives in a leaf, 0 for interior nodes
+};
+
+static_assert(sizeof(BVHNode) == 32, "BVHNode must match the std430 layout of BVHNode");
+
+struct Mesh;
+
+// Bounding volume hierarchy over the scene objects or the triangles of a mesh, built with binned SAH splits
+class BVH {
+private:
+    struct BuildPrimitive {
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+        glm::vec3 centroid;
+        int index;
+    };
+
+    std::vector<BVHNode> nodes;
+    std::vector<int> primitive_indices;
+    std::vector<BuildPrimitive> build_primitives;
+    // Only kept for a BVH over objects, so Refit can walk up from a moved object: the parent of every node (-1 for the
+    // root), the leaf and bounds of every object (-1 for those left out) and the area of every node when it was built
+    std::vector<int> parents;
+    std::vector<int> primitive_leaves;
+    std::vector<std::pair<glm::vec3, glm::vec3>> primitive_bounds;
+    std::vector<float> build_areas;
+    // Nodes Refit has already queued, all false between refits
+    std::vector<char> refit_marks;
+    // Sums over the nodes of their SAH weight times their area relative to the build, and of the weights alone.
+    // Double so adding and taking away the same growth over thousands of refits does not drift
+    double weighted_growth;
+    double total_weight;
+
+    void BuildPrimitives();
+    int BuildNode(size_t begin, size_t end, int depth);
+    void MakeLeaf(BVHNode& node, size_t begin, size_t end);
+    void SetNodeBounds(int node_index, const glm::vec3& bounds_min, const glm::vec3& bounds_max);
+public:
+    BVH();
+
+    // Mesh objects are bounded by their mesh, those without one are skipped like null objects
+    void Build(const std::vector<Object>& objects, const std::vector<std::shared_ptr<const Mesh>>& meshes = {});
+    void BuildTriangles(const std::vector<glm::vec3>& positions, const std::vector<glm::uvec3>& triangles);
+    // Moves the bounds of the leaves holding the objects in the ranges and of every node above them, the tree keeps its
+    // shape. Returns false if it cannot: objects were added, removed or left out of the BVH or put back into it, or the
+    // growth passed BVH_REFIT_GROWTH_LIMIT. The objects have to be built again then
+    bool Refit(const std::vector<Object>& objects, const std::vector<std::shared_ptr<const Mesh>>& meshes,
+        const std::vector<std::pair<size_t, size_t>>& ranges);
+
+    // Getters
+    const std::vector<BVHNode>& GetNodes() const;
+    const std::vector<int>& GetPrimitiveIndices() const;
+    // Expected cost of tracing a ray through the tree relative to intersecting one primitive (the SAH cost)
+    float GetCost() const;
+    // How much the SAH terms of the nodes grew since the last build on average, weighted like the SAH, 1 right after it.
+    // The SAH cost itself measures areas relative to the root, so a ground sphere a thousand units wide would hide
+    // every change among the objects on it
+    float GetGrowth() const;
+};
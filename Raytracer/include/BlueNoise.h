@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Side of the tileable blue noise pattern, matches BLUE_NOISE_SIZE in raytracing_common.glsl
+#define BLUE_NOISE_SIZE 64
+// Texture unit the ray tracing shaders read the pattern from
+#define BLUE_NOISE_TEXTURE_UNIT 1
+
+// Void and cluster (Ulichney 1993): a rank for every pixel, row major, such that the pixels below any rank are evenly spread.
+// Deterministic for a seed, so the GPU texture and CPURenderer use the same pattern
+std::vector<uint16_t> GenerateBlueNoise(unsigned int seed = 0);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/Enums.h"
+#include "../include/Object.h"
+#include "../include/Scene.h"
+#include "../include/CPUScene.h"
+#include "../include/TileScheduler.h"
+
+// Default edge of the square tiles, in pixels
+#define CPU_TILE_SIZE 16
+// Most paths traced together when sorting rays, 4 samples of every pixel of a 16 x 16 tile. Larger waves sort better
+// but no longer fit in cache
+#define CPU_WAVE_SIZE 1024
+
+// Rays of a render with sorting on, and how many of them were in the same bin as the ray before them as they arrived and
+// once sorted. The more in a row share a bin, the more of the BVH and of the material code the next one finds in cache
+struct RayCoherence {
+    long long intersected;
+    long long octant_arrived; // octant of the direction, before the hit test
+    long long octant_sorted;
+    long long shaded;
+    long long material_arrived; // type of the material hit, or a miss, before shading
+    long long material_sorted;
+};
+
+// Reference path tracer that runs the same kernel as raytracing_common.glsl on the CPU, split into tiles across all cores by a
+// TileScheduler.
+// Needs no GL context, so it also renders on machines without a GPU
+class CPURenderer {
+private:
+    int light_bounces;
+    TileScheduler scheduler;
+    SamplerType sampler;
+    int roulette_depth;
+    std::vector<uint16_t> blue_noise; // generated on the first render that needs it
+
+    // Scene and camera of the current render
+    CPUScene cpu_scene;
+    glm::vec3 sky_horizon;
+    glm::vec3 sky_zenith;
+    glm::vec3 pixel00;
+    glm::vec3 pixel_delta_u;
+    glm::vec3 pixel_delta_v;
+    glm::vec3 camera_center;
+    unsigned int frame;
+    int samples_per_pixel;
+
+    // Linear radiance, rows from the bottom up like the GL render target
+    int width;
+    int height;
+    std::vector<glm::vec3> radiance;
+
+    // Traces the paths of a tile a bounce at a time and sorts their rays between bounces
+    bool sort_rays;
+    RayCoherence coherence; // of the last render
+    std::mutex coherence_mutex;
+
+    void RenderTile(const Tile& tile);
+public:
+    // A thread count of 0 uses every hardware thread, a negative roulette depth never ends paths early
+    CPURenderer(int light_bounces = 20, int thread_count = 0, SamplerType sampler = SamplerType::Random, int roulette_depth = -1, int tile_size = CPU_TILE_SIZE);
+
+    void Render(const Scene& scene, int width, int height, int samples_per_pixel, unsigned int frame = 0);
+    // Top row first as RGB, the same layout as Renderer::ReadRadiance
+    std::vector<float> ReadRadiance() const;
+
+    // Getters
+    int GetThreadCount() const;
+    int GetTileSize() const;
+    // Tiles that threads took from others during the last render
+    int GetStolenTiles() const;
+    RayCoherence GetRayCoherence() const;
+
+    // Setters
+    // The image stays the same, only the order the rays are traced in changes
+    void SetRaySorting(bool sort);
+};
+
+// Scatters hits on the materials of preset 2 by the switch on MaterialType and by std::visit on MaterialVariant, in
+// random order and sorted by material, and prints the scatters per second of both. Returns false if they disagree
+bool RunMaterialBenchmark(unsigned int seed);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <variant>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../include/BVH.h"
+#include "../include/Mesh.h"
+#include "../include/Object.h"
+#include "../include/SphereSoA.h"
+
+// What the intersection tests read of an object, 32 bytes so two share a cache line and the centre and radius of a
+// sphere are one aligned load
+struct alignas(16) ObjectShape {
+    glm::vec3 position;
+    float radius; // scale.x, the radius of spheres
+    glm::vec3 scale;
+    ObjectType type;
+};
+
+// A material as one type per MaterialType, so the CPU renderer can pick its scatter function at compile time with
+// std::visit. Only what scattering reads, the emission and light sampling keep using Material
+struct Lambertian {
+    glm::vec3 albedo;
+};
+struct Metal {
+    glm::vec3 albedo;
+    float fuzz;
+};
+struct Dielectric {
+    float refraction_index;
+};
+// Emissive and null materials. Emissive ones end the path before scattering
+struct Absorbing {};
+typedef std::variant<Lambertian, Metal, Dielectric, Absorbing> MaterialVariant;
+
+MaterialVariant ToMaterialVariant(const Material& material);
+
+// Scene::objects compiled for CPURenderer the way SceneBuffer packs them for the GPU: the shapes sit in the order of the
+// BVH leaves and refer to a table of materials by index, so the intersection tests never load a material and only the
+// nearest hit of a ray fetches one
+struct CPUScene {
+    BVH bvh;
+    std::vector<std::shared_ptr<const Mesh>> meshes;
+    // One per BVH slot, the position of the object in bvh.GetPrimitiveIndices()
+    std::vector<ObjectShape> shapes;
+    std::vector<int> materials; // into material_table
+    std::vector<const Mesh*> slot_meshes; // ObjectType::Mesh only
+    std::vector<glm::quat> rotations; // InstanceRotation, ObjectType::Mesh only
+    // Every distinct material once, and the same as variants
+    std::vector<Material> material_table;
+    std::vector<MaterialVariant> material_variants;
+    SphereSoA spheres;
+    // Slots of the lights FindLights picks, in its order
+    std::vector<int> lights;
+
+    // Compiles everything again, the meshes are shared with the scene
+    void Build(const std::vector<Object>& objects, const std::vector<std::shared_ptr<const Mesh>>& scene_meshes);
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+// Scales are rounded down to multiples of this so the render target is not resized for tiny changes
+#define DYNAMIC_RESOLUTION_STEP (1.0f / 32.0f)
+// Frames without camera movement before full resolution is restored
+#define DYNAMIC_RESOLUTION_SETTLE_FRAMES 10
+
+// Picks the render scale, and optionally the samples per pixel, that keep the ray tracing pass within a time budget.
+// The cost of a sample is learned from the GPU timings, so a change is sized in one step instead of creeping towards it
+class DynamicResolution {
+private:
+    float scale;
+    int samples;
+    double cost_per_sample; // milliseconds, smoothed over recent passes
+    int still_frames;
+public:
+    float target_ms;
+    float min_scale;
+    bool adjust_samples;
+
+    DynamicResolution(float target_ms = 16.6f, float min_scale = 0.25f, bool adjust_samples = false);
+
+    void AddMeasurement(double milliseconds, long long pass_samples);
+    // Returns true when the scale or samples of the next pass changed
+    bool Update(bool camera_moved, float max_scale, int max_samples, int window_width, int window_height);
+    void Reset(float max_scale, int max_samples);
+
+    // Getters
+    bool IsSettled() const;
+    float GetScale(float max_scale) const;
+    int GetSamples(int max_samples) const;
+};
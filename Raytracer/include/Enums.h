@@ -7,4 +7,22 @@ enum Direction {
     BACKWARD,
     UPWARD,
     DOWNWARD
+};
+
+enum class Tonemapper {
+    None,
+    Reinhard,
+    ACES
+};
+
+enum class RenderPipeline {
+    Fragment,
+    Wavefront
+};
+
+// Where the sample dimensions come from, matches the SAMPLER_ defines in raytracing_common.glsl
+enum class SamplerType {
+    Random,
+    Sobol,
+    BlueNoise
 };
\ No newline at end of file
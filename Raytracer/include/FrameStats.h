@@ -0,0 +1,27 @@
+#pragma once
+
+// Number of most recent values kept for the statistics and plots
+#define FRAME_STATS_HISTORY 240
+
+// Rolling statistics over the most recent values of a per frame measurement
+class FrameStats {
+private:
+    float history[FRAME_STATS_HISTORY];
+    int count;
+    int offset; // index of the oldest value once the history is full
+public:
+    FrameStats();
+
+    void Add(float value);
+    void Clear();
+
+    // Getters
+    float GetLatest() const;
+    float GetMin() const;
+    float GetAverage() const;
+    float GetPercentile(float percentile) const;
+    // For ImGui::PlotLines, which starts drawing at the offset and wraps around
+    const float* GetHistory() const;
+    int GetCount() const;
+    int GetOffset() const;
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+// Image size and samples of the furnace renders
+#define FURNACE_TEST_WIDTH 64
+#define FURNACE_TEST_HEIGHT 40
+#define FURNACE_TEST_SAMPLES 256
+// Largest mean difference from the analytic radiance over the upward and the downward facing half of the sphere, for
+// the renders under a uniform sky. The gradient sky takes a quarter of the difference uniform hemisphere sampling makes
+#define FURNACE_TEST_TOLERANCE 0.01
+
+// Renders CreateFurnaceScene under a uniform sky, where every pixel converges to the albedo, and under a sky that brightens
+// linearly upwards, where a cosine weighted bounce around the normal n converges to albedo * (1 + 2/3 n.y).
+// The first one holds for any hemisphere sampler and only checks the weight of a bounce. The second one checks that
+// bounces are cosine weighted around the normal and fails uniform hemisphere sampling. A third render swaps the sphere
+// for a triangle mesh under the uniform sky, which catches rays leaking between triangles. With check_gpu, also runs
+// both GPU pipelines, which needs a current GL context. Prints a report and returns false if anything fails
+bool RunFurnaceTests(bool check_gpu);
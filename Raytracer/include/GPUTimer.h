@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <deque>
+
+// Queries in flight per timer, results are read back this many passes later
+#define GPU_TIMER_SLOTS 2
+// Binding point and size of the ray counter storage buffer in raytracing_common.glsl
+#define RAY_COUNTER_BINDING 3
+#define RAY_COUNTER_SLOTS 64
+
+struct GPUTimerResult {
+    double milliseconds;
+    long long samples;          // as passed to Begin
+    unsigned long long rays;    // ray segments traced, 0 unless the timer counts rays
+};
+
+// Times a GPU pass with a GL_TIME_ELAPSED query and optionally counts the rays it traces.
+// Every Begin uses the next slot, so a result is only read back once the GPU is done with it
+class GPUTimer {
+private:
+    struct Slot {
+        GLuint query;
+        GLuint ray_counter;
+        bool pending;
+        long long samples;
+    };
+
+    Slot slots[GPU_TIMER_SLOTS];
+    int next_slot;
+    bool count_rays;
+    std::deque<GPUTimerResult> ready;
+
+    void Read(Slot& slot);
+public:
+    GPUTimer(bool count_rays = false);
+    ~GPUTimer();
+
+    void Begin(long long samples = 0);
+    void End();
+    // Returns the oldest finished result without waiting for the GPU
+    bool Collect(GPUTimerResult& result);
+    void Release();
+
+    // Getters
+    int GetLiveObjectCount() const;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../include/Enums.h"
+
+// Both take tightly packed RGB rows ordered from the top of the image down
+bool WritePPM(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels);
+// Linear float radiance, for comparing renders without the display transform
+bool WritePFM(const std::string& path, int width, int height, const std::vector<float>& pixels);
+// The display pass of fullscreen_quad.fs.glsl on the CPU: exposure, tonemapping and gamma, quantised to 8 bits
+std::vector<unsigned char> ApplyDisplayTransform(const std::vector<float>& radiance, Tonemapper tonemapper, float exposure, float gamma);
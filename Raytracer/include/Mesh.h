@@ -0,0 +1,36 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../include/BVH.h"
+#include "../include/Object.h"
+
+// Indexed triangle mesh in its own object space, placed in the scene by ObjectType::Mesh objects.
+// Immutable once built, so every object and renderer shares the same one
+struct Mesh {
+    std::string name;
+    std::vector<glm::vec3> positions;
+    // One per position. Vertices without a normal in the file are 0 and shaded with the normal of the triangle
+    std::vector<glm::vec3> normals;
+    // Indices of the three vertices, stored in the order of the BVH leaves so a leaf covers a range of them
+    std::vector<glm::uvec3> triangles;
+    BVH bvh;
+
+    // Builds the BVH over the triangles and reorders them to match it
+    void Build();
+};
+
+// Reads the v, vn and f lines of a Wavefront OBJ file, polygons are split into fans of triangles.
+// Corners that share a position and a normal become one vertex. Returns false and prints the line on errors
+bool LoadOBJ(const std::string& path, Mesh& mesh);
+
+// Rotation of a mesh object from its mesh into the scene. Computed once on the CPU so every backend uses the same floats
+glm::quat InstanceRotation(const Object& object);
+
+// Closed icosahedron with every face split into four subdivisions times, on the unit sphere and without normals
+std::shared_ptr<Mesh> CreateIcosphere(int subdivisions);
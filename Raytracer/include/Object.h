@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Enumerations
+// Matches the OBJECT_ defines in raytracing_common.glsl
+enum class ObjectType {
+    NullObject,
+    Sphere,
+    // Axis aligned rectangle around position, scale holds its half size and is 0 along the axis it faces
+    Quad,
+    // Instance of a triangle mesh from Scene::meshes: scaled per axis, rotated, then moved to position
+    Mesh
+};
+
+// Matches the MATERIAL_ defines in raytracing_common.glsl
+enum class MaterialType {
+    NullMaterial,
+    Lambertian,
+    Metal,
+    Dielectric,
+    // Light source, albedo is the emitted radiance. Spheres emit outwards, quads from both sides
+    Emissive
+};
+
+// Structs
+struct Material {
+    MaterialType type;
+    glm::vec3 albedo;
+    float fuzz;
+    float refraction_index;
+};
+
+struct Object {
+    ObjectType type;
+    glm::vec3 position;
+    glm::vec3 scale;
+    Material material;
+    int mesh = -1; // index into the scene meshes, only used by ObjectType::Mesh
+    glm::vec3 rotation = glm::vec3(0.0f); // degrees about x, then y, then z, only used by ObjectType::Mesh
+};
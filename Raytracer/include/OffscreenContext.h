@@ -0,0 +1,17 @@
+#pragma once
+
+// An OpenGL 4.3 core context without a visible window, for rendering on machines without a display.
+// Linux uses a surfaceless EGL context (works with Mesa llvmpipe on machines without a GPU),
+// Windows falls back to a hidden GLFW window
+class OffscreenContext {
+private:
+    // EGL display and context, or the hidden GLFW window on Windows
+    void* display;
+    void* context;
+public:
+    OffscreenContext();
+    ~OffscreenContext();
+
+    bool Create();
+    void Destroy();
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// CPU twin of the random number generator in raytracing_common.glsl, both produce the same bits.
+// Every sample of every pixel starts from its own state and each draw advances it, so bounces are not correlated
+
+// Advances the state and returns the next 32 random bits
+uint32_t PCGNext(uint32_t& state);
+uint32_t PCGHash(uint32_t value);
+// Starting state for one sample of one pixel
+uint32_t InitRandom(uint32_t x, uint32_t y, uint32_t sample_index, uint32_t frame);
+// Uniform in [0, 1)
+float RandomFloat(uint32_t& state);
+// The top 24 bits as a float in [0, 1)
+float ToUnitFloat(uint32_t bits);
+
+// Pieces of the Owen scrambled Sobol sampler in raytracing_common.glsl
+uint32_t ReverseBits(uint32_t x);
+uint32_t NestedUniformScramble(uint32_t x, uint32_t seed);
+// Second Sobol dimension, the first is the bit reversed index
+uint32_t Sobol1(uint32_t index);
@@ -0,0 +1,11 @@
+#pragma once
+
+// Draws per pixel compared between the GPU and Random.cpp, matches random_test.cs.glsl
+#define RANDOM_TEST_DRAWS 8
+// Pixels on a side of the image the statistics are gathered over
+#define RANDOM_TEST_SIZE 256
+
+// Checks that the random numbers are uniform and that bounces, neighbouring pixels, samples and frames are uncorrelated,
+// next to the sin hash they replaced. With check_gpu, also that the shader produces the same bits as the CPU twin,
+// which needs a current GL context. Prints a report and returns false if anything fails
+bool RunRandomTests(bool check_gpu);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <unordered_map>
+#include <string>
+
+// A framebuffer with a single texture colour attachment
+struct RenderTarget {
+    GLuint fbo;
+    GLuint texture;
+    int width;
+    int height;
+    GLint internal_format;
+};
+
+// Owns the offscreen render targets and only reallocates them when their size or format changes
+class RenderTargetManager {
+private:
+    std::unordered_map<std::string, RenderTarget> targets;
+    int live_objects;
+
+    void Allocate(RenderTarget& target);
+    void Free(RenderTarget& target);
+public:
+    RenderTargetManager();
+    ~RenderTargetManager();
+
+    const RenderTarget& Acquire(const std::string& name, int width, int height, GLint internal_format = GL_RGBA8);
+    void Release(const std::string& name);
+    void ReleaseAll();
+
+    // Getters
+    int GetLiveObjectCount() const;
+};
@@ -2,43 +2,29 @@
 
 #include <GLFW/glfw3.h>
 
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include <glm/glm.hpp>
 
 #include "../include/Shader.h"
 #include "../include/Camera.h"
-
-// Enumerations
-enum class ObjectType {
-    NullObject,
-    Sphere
-};
-
-enum class MaterialType {
-    NullMaterial,
-    Lambertian,
-    Metal,
-    Dielectric
-};
-
-// Structs
-struct Material {
-    MaterialType type;
-    glm::vec3 albedo;
-    float fuzz;
-    float refraction_index;
-};
-
-struct Object {
-    ObjectType type;
-    glm::vec3 position;
-    glm::vec3 scale;
-    Material material;
-};
+#include "../include/Enums.h"
+#include "../include/RenderTarget.h"
+#include "../include/Object.h"
+#include "../include/SceneObjects.h"
+#include "../include/SceneBuffer.h"
+#include "../include/BVH.h"
+#include "../include/Mesh.h"
+#include "../include/Scene.h"
+#include "../include/GPUTimer.h"
+#include "../include/FrameStats.h"
+#include "../include/DynamicResolution.h"
+#include "../include/WavefrontPipeline.h"
 
 class Renderer {
 private:
@@ -54,17 +40,80 @@ private:
     std::unordered_map<std::string, GLuint> vbo;
     std::unordered_map<std::string, GLuint> vao;
     std::unordered_map<std::string, GLuint> ibo;
+    std::unordered_map<std::string, GLuint> textures;
+    RenderTargetManager render_targets;
     GLuint fbo;
     GLuint fbo_texture;
 
     // Scene settings
     int light_bounces;
+    // Paths are ended by russian roulette after roulette_depth bounces
+    bool russian_roulette;
+    int roulette_depth;
     int samples_per_pixel;
     float resolution_factor;
     bool show_tooltip;
+    bool run_benchmark;
+    bool run_pipeline_benchmark;
+
+    // Path tracer used for the ray tracing pass, the fragment shader or the wavefront compute kernels
+    RenderPipeline pipeline;
+    WavefrontPipeline wavefront;
+    // Bins the rays of the wavefront pipeline by direction between bounces
+    bool sort_rays;
+    // Source of the random dimensions of every sample, for both pipelines
+    SamplerType sampler;
+
+    // Scale and samples of the next ray tracing pass, the settings above unless dynamic resolution lowers them
+    float render_scale;
+    int render_samples;
+    bool use_dynamic_resolution;
+    DynamicResolution dynamic_resolution;
+
+    // Progressive accumulation
+    bool progressive;
+    int accumulated_samples;
+    int max_accumulated_samples;
+    glm::vec3 last_look_from;
+    glm::vec3 last_look_at;
+    float last_vfov;
+    // Index of the image being traced, every pass accumulating into the same image shares it
+    unsigned int frame_index;
+
+    // Display transform, applied when the HDR target is drawn to the screen
+    Tonemapper tonemapper;
+    float exposure;
+    float gamma;
+
+    // Timings of the GPU passes and rolling statistics, read back a frame late
+    std::unordered_map<std::string, std::unique_ptr<GPUTimer>> gpu_timers;
+    std::unordered_map<std::string, FrameStats> frame_stats;
+    // How often the scene BVH was refitted and built since the start, their times are in frame_stats
+    int bvh_refit_count;
+    int bvh_rebuild_count;
+    std::chrono::high_resolution_clock::time_point last_frame_time;
+    // Whether the fragment shader counts its rays, only while the Performance window shows them
+    bool count_rays;
+
+    // Benchmark results as (object count, milliseconds per frame)
+    std::vector<std::pair<int, double>> object_count_benchmark;
+    // Benchmark results as (scene, fragment milliseconds per frame, wavefront milliseconds per frame)
+    std::vector<std::tuple<std::string, double, double>> pipeline_benchmark;
+
+    // Background of the scene
+    glm::vec3 sky_horizon;
+    glm::vec3 sky_zenith;
 
     // Objects in the scene
-    std::vector<Object> scene_objects;
+    SceneObjects scene_objects;
+    SceneBuffer scene_buffer;
+    BVH bvh;
+    // Meshes the mesh objects can place, uploaded again when one is added
+    std::vector<std::shared_ptr<const Mesh>> meshes;
+    bool meshes_dirty;
+    char obj_path[256];
+    // Emissive objects sampled directly, found again whenever the objects change
+    std::vector<int> lights;
 
     // Private Methods
     //scene setup
@@ -72,16 +121,16 @@ private:
     void SetupTextureAttachment();
     void SetupScreenQuad();
     void SetupShaders();
-    //presets
-    void ApplyPreset1();
-    void ApplyPreset2();
-
+    void SetupTimers();
+    void SetupBlueNoise();
     //imgUI
     void InitImGui(GLFWwindow* window);
     void ShutdownImGui();
     void RenderUI();
     void RenderSceneSettings();
     void RenderCameraSettings();
+    void RenderDisplaySettings();
+    void RenderPerformance();
     void RenderPresetsMenu();
     void RenderObjectsUI();
     void RenderToolTip(bool is_open);
@@ -93,9 +142,19 @@ private:
 
     void UpdateFBO(int width, int height);
     void SendUniforms(float window_width, float window_height);
+    void UploadScene();
     void RenderObjects();
+    void TraceWavefront(int width, int height);
     void SendQuadUniforms(float window_width, float window_height);
     void RenderScreenQuad(GLuint texture);
+    bool CameraMoved();
+    void ResetAccumulation();
+    static void FlipRows(void* pixels, size_t row_size, int height);
+    //profiling
+    void CollectTimings();
+    //benchmarks
+    void RenderBenchmarkResults();
+    void RenderPipelineBenchmarkResults();
 
 public:
     // Public Members
@@ -113,4 +172,25 @@ public:
     );
     ~Renderer();
     void Render(GLFWwindow* window);
+    void RunObjectCountBenchmark(int window_width, int window_height);
+    void RunPipelineBenchmark(int window_width, int window_height);
+    void ApplyScene(const Scene& scene);
+    void SetDisplaySettings(Tonemapper display_tonemapper, float display_exposure, float display_gamma);
+    void SetPipeline(RenderPipeline render_pipeline);
+    void SetSampler(SamplerType render_sampler);
+    void SetRaySorting(bool sort);
+    // Makes the wavefront pipeline count how often neighbouring rays share an octant, see ReadRayCoherence
+    void SetCoherenceCounting(bool count);
+    // A negative depth turns russian roulette off
+    void SetRussianRoulette(int min_depth);
+    //offscreen rendering, the results are read back top row first as RGB.
+    //The frame seeds the samples, the default one matches CPURenderer::Render
+    void RenderOffscreen(int width, int height, int total_samples, unsigned int frame = 0);
+    std::vector<unsigned char> ReadPixels(int width, int height);
+    std::vector<float> ReadRadiance(int width, int height);
+    // Rays the wavefront pipeline intersected since the last call and how many went the same way as the ray before them
+    void ReadRayCoherence(unsigned long long& rays, unsigned long long& coherent_rays);
+
+    // Getters
+    int GetLiveGLObjectCount() const;
 };
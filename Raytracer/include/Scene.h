@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/Object.h"
+#include "../include/Mesh.h"
+
+// Rows and columns of mesh objects in the instances preset
+#define INSTANCE_GRID_SIZE 64
+
+// Most emissive objects that are sampled directly, matches raytracing_common.glsl. Further ones are only found by scattering
+#define MAX_LIGHT_COUNT 16
+
+// Objects and camera placement, independent of any window or GL context
+struct Scene {
+    std::vector<Object> objects;
+    // Meshes the mesh objects point into, shared by every copy of the scene
+    std::vector<std::shared_ptr<const Mesh>> meshes;
+    glm::vec3 look_from = glm::vec3{ 0,0,1 };
+    glm::vec3 look_at = glm::vec3{ 0,0,0 };
+    float vfov = 90.0f;
+    // Radiance of rays that leave the scene, blended from the horizon to straight up
+    glm::vec3 sky_horizon = glm::vec3{ 1.0f, 1.0f, 1.0f };
+    glm::vec3 sky_zenith = glm::vec3{ 0.5f, 0.7f, 1.0f };
+};
+
+// Presets
+Scene CreatePreset1();
+Scene CreatePreset2(unsigned int seed = std::random_device{}());
+// White furnace: a lambertian sphere that fills the view under a uniform white sky.
+// Every bounce off a convex sphere escapes, so every pixel converges to the albedo if scattering conserves energy
+Scene CreateFurnaceScene(float albedo = 0.5f);
+// Box lit only by a small quad in the ceiling and a small glowing sphere, under a black sky
+Scene CreateLightsPreset();
+// A grid of INSTANCE_GRID_SIZE squared rotated and stretched copies of one small mesh, which is stored only once
+Scene CreateInstancesPreset(unsigned int seed = std::random_device{}());
+
+// Indices of the emissive spheres and quads the path tracers sample directly, the first MAX_LIGHT_COUNT of them.
+// Emissive meshes are only found by scattering
+std::vector<int> FindLights(const std::vector<Object>& objects);
+
+// Reads a scene description, one entry per line, '#' starts a comment:
+//   camera <from x y z> <at x y z> <vfov>
+//   sky <horizon r g b> <zenith r g b>
+//   sphere <x y z> <radius> <material>
+//   quad <x y z> <half size x y z> <material>, one half size is 0
+//   mesh <obj path> <x y z> <scale x y z> [<rotation x y z>] <material>, the path is relative to the scene file, the
+//     scale is not 0 and the rotation is in degrees about x, then y, then z
+// where <material> is one of:
+//   lambertian <r g b>
+//   metal <r g b> <fuzz>
+//   dielectric <refraction index>
+//   emissive <r g b>
+bool LoadScene(const std::string& path, Scene& scene);
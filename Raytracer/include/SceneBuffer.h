@@ -0,0 +1,91 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/Object.h"
+#include "../include/Mesh.h"
+#include "../include/SceneObjects.h"
+#include "../include/BVH.h"
+
+// Mirror of the Material struct in raytracing_common.glsl, read from the material texture two texels at a time
+struct GPUMaterial {
+    glm::vec3 albedo;
+    int type;
+    float fuzz;
+    float refraction_index;
+    float padding[2];
+};
+
+// std430 mirror of the Object struct in raytracing_common.glsl. A mesh instance is a transform, a material index and
+// the root of the shared mesh BVH
+struct GPUObject {
+    glm::vec3 position;
+    int type;
+    glm::vec3 scale;
+    int material;       // index into the material texture
+    glm::vec4 rotation; // unit quaternion (x, y, z, w) of a mesh instance
+    int mesh_root;      // node of the mesh BVH in the mesh node texture, -1 for other objects
+    int padding[3];
+};
+
+static_assert(sizeof(GPUMaterial) == 32, "GPUMaterial must be two texels of the material texture");
+static_assert(sizeof(GPUObject) == 64, "GPUObject must match the std430 layout of Object");
+
+// Binding points of the storage buffers in raytracing_common.glsl
+#define OBJECT_BUFFER_BINDING 0
+#define BVH_NODE_BUFFER_BINDING 1
+#define BVH_INDEX_BUFFER_BINDING 2
+// Texture units of the mesh texture buffers in raytracing_common.glsl. Texture buffers leave the storage buffer bindings,
+// which the wavefront kernels already use up, to the rest of the renderer
+#define MESH_VERTEX_TEXTURE_UNIT 2
+#define MESH_TRIANGLE_TEXTURE_UNIT 3
+#define MESH_NODE_TEXTURE_UNIT 4
+#define MATERIAL_TEXTURE_UNIT 5
+
+// Shader storage buffers holding the packed scene objects and their BVH, and texture buffers holding every mesh and
+// the distinct materials of the objects
+class SceneBuffer {
+private:
+    GLuint object_buffer;
+    GLuint node_buffer;
+    GLuint index_buffer;
+    // Buffers and the textures viewing them: vertices, triangles, BVH nodes
+    GLuint mesh_buffers[3];
+    GLuint mesh_textures[3];
+    size_t capacity;
+    std::vector<GPUObject> staging;
+    // First node of each mesh in the mesh node texture
+    std::vector<int> mesh_roots;
+    // Every material packed so far and where it is. Edits only add materials, stale ones go on the next full upload
+    GLuint material_buffer;
+    GLuint material_texture;
+    std::vector<GPUMaterial> materials;
+    std::map<std::tuple<int, float, float, float, float, float>, int> material_indices;
+    size_t uploaded_material_count;
+
+    GPUObject Pack(const Object& object);
+    int FindMaterial(const Material& material);
+    void UploadMaterials();
+    static void UploadWhole(GLuint& buffer, const void* data, size_t size);
+public:
+    SceneBuffer(size_t capacity);
+    ~SceneBuffer();
+
+    // Uploads only the dirty ranges of the objects, unless the buffer has to grow or stale materials pile up
+    void Upload(const SceneObjects& objects);
+    void UploadBVH(const BVH& bvh);
+    // All meshes back to back, every index made absolute. The objects have to be uploaded again afterwards
+    void UploadMeshes(const std::vector<std::shared_ptr<const Mesh>>& meshes);
+    void Bind() const;
+    void Release();
+
+    // Getters
+    int GetLiveObjectCount() const;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "../include/Object.h"
+
+// The objects in the scene along with the index ranges modified since the last upload
+class SceneObjects {
+private:
+    std::vector<Object> objects;
+    // Sorted, non-overlapping [begin, end) ranges
+    std::vector<std::pair<size_t, size_t>> dirty_ranges;
+public:
+    SceneObjects();
+
+    // Direct access does not record a change, call MarkDirty after editing in place
+    Object& operator[](size_t index);
+    const Object& operator[](size_t index) const;
+
+    void Add(const Object& object);
+    void Set(size_t index, const Object& object);
+    void Remove(size_t index);
+    void Clear();
+
+    void MarkDirty(size_t index);
+    void MarkDirty(size_t begin, size_t end);
+    void ClearDirty();
+
+    // Getters
+    size_t Size() const;
+    bool IsDirty() const;
+    const std::vector<Object>& GetObjects() const;
+    const std::vector<std::pair<size_t, size_t>>& GetDirtyRanges() const;
+};
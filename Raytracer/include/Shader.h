@@ -2,13 +2,19 @@
 
 #include <string>
 
+// Nested #include directives allowed in a shader file
+#define MAX_INCLUDE_DEPTH 8
+
 class Shader {
 private:
     unsigned int id; // Shader program ID
     void CheckCompileErrors(unsigned int shader, const std::string& type);
+    static bool ReadSource(const std::string& path, std::string& source, int depth = 0);
 public:
     // Constructor reads and builds the shader
     Shader(const char* vertexPath, const char* fragmentPath);
+    // Compute shader program
+    Shader(const char* computePath);
 
     ~Shader();
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/BVH.h"
+#include "../include/Object.h"
+
+// Spheres HitSpheres tests per instruction: 8 with AVX, 4 with SSE2 (every x64 build), one at a time elsewhere
+#if defined(__AVX__)
+#define SPHERE_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPHERE_LANES 4
+#else
+#define SPHERE_LANES 1
+#endif
+// Most spheres a BVH subtree can hold to be tested in one go instead of box by box
+#define SPHERE_BATCH_SIZE 8
+
+// Centres and radii of the spheres in structure of arrays form, in the order of a BVH's primitive indices so the spheres
+// of a subtree sit next to each other. Slots of other objects have a NaN radius, which no ray hits
+struct SphereSoA {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+    // First slot and count of the spheres under every node of the BVH, a count of 0 if it holds more than
+    // SPHERE_BATCH_SIZE objects or anything but spheres
+    std::vector<glm::ivec2> batches;
+
+    // Padded by SPHERE_LANES slots, so the last spheres can be loaded a whole register at a time too
+    void Build(const std::vector<Object>& objects, const BVH& bvh);
+};
+
+// Writes where the ray first meets each of the count spheres from first within (t_min, t_max), or INFINITY if it does
+// not. The same floats as hitSphere in CPURenderer.cpp, so the nearest of them is the hit it would find
+void HitSpheres(const SphereSoA& spheres, int first, int count, const glm::vec3& origin, const glm::vec3& direction, float t_min, float t_max, float* t);
+// One sphere at a time, the fallback without SIMD and the baseline of --benchmark spheres
+void HitSpheresScalar(const SphereSoA& spheres, int first, int count, const glm::vec3& origin, const glm::vec3& direction, float t_min, float t_max, float* t);
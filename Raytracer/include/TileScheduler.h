@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Pixels [min, max) of an image
+struct Tile {
+    glm::ivec2 min;
+    glm::ivec2 max;
+};
+
+// Splits images into square tiles and renders them on a group of threads. The tiles are sorted along a Morton curve
+// and every thread starts with its own stretch of it, so neighbouring tiles run on the same core. A thread that runs
+// out steals the far half of the longest remaining stretch, which keeps all of them busy when some tiles take far
+// longer than others, like glass against sky
+class TileScheduler {
+private:
+    // Tiles one thread still has to render, it takes them from the front and thieves from the back
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<int> tiles;
+    };
+
+    int thread_count;
+    int tile_size;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<int> stolen_tiles;
+
+    // Moves tiles from the busiest other queue to the thread's own, returns false once every queue is empty
+    bool Steal(int thread);
+public:
+    // A thread count of 0 uses every hardware thread
+    TileScheduler(int thread_count = 0, int tile_size = 16);
+
+    // Calls render_tile once for every tile of a width x height image and returns when all are done. Tiles run in
+    // parallel, so render_tile must only write the pixels of its tile
+    void Run(int width, int height, const std::function<void(const Tile&)>& render_tile);
+
+    // Getters
+    int GetThreadCount() const;
+    int GetTileSize() const;
+    // Of the last Run
+    int GetStolenTiles() const;
+};
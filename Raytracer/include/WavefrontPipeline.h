@@ -0,0 +1,104 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/Shader.h"
+#include "../include/Camera.h"
+#include "../include/Enums.h"
+
+// Threads per work group of the wavefront kernels, matches wavefront_common.glsl
+#define WAVEFRONT_GROUP_SIZE 64
+// Queues of paths waiting to be shaded: lambertian, metal, dielectric
+#define WAVEFRONT_MATERIAL_QUEUES 3
+// Bins of the ray sorting pass, one per octant of the direction
+#define WAVEFRONT_OCTANTS 8
+// Queues in the queue buffer: two ray queues that swap roles every bounce, the material queues, then the rays waiting to
+// be sorted
+#define WAVEFRONT_QUEUE_COUNT (2 + WAVEFRONT_MATERIAL_QUEUES + 1)
+// Binding points of the storage buffers in wavefront_common.glsl, after the scene buffers and the ray counter.
+// Eight blocks in all, the fewest a GL 4.3 implementation has to support in a compute shader
+#define WAVEFRONT_PATH_BUFFER_BINDING 4
+#define WAVEFRONT_RADIANCE_BUFFER_BINDING 5
+#define WAVEFRONT_QUEUE_BUFFER_BINDING 6
+#define WAVEFRONT_QUEUE_STATE_BINDING 7
+
+// std430 mirror of the Path struct in wavefront_common.glsl
+struct WavefrontPath {
+    glm::vec3 origin;
+    int depth;
+    glm::vec3 direction;
+    GLuint rng;
+    glm::vec3 throughput;
+    int object;
+    glm::vec3 hit_point;
+    int front_face;
+    glm::vec3 normal;
+    GLuint dimension;
+    float bsdf_pdf;
+    float padding[3];
+};
+
+// std430 mirror of the QueueState block in wavefront_common.glsl
+struct WavefrontQueueState {
+    GLuint dispatch[1 + WAVEFRONT_MATERIAL_QUEUES][4]; // x, y, z and padding for glDispatchComputeIndirect
+    GLuint ray_count;
+    GLuint next_ray_count;
+    GLuint material_counts[WAVEFRONT_MATERIAL_QUEUES];
+    GLuint octant_counts[WAVEFRONT_OCTANTS];
+    GLuint intersected_rays;
+    GLuint coherent_rays;
+};
+
+static_assert(sizeof(WavefrontPath) == 96, "WavefrontPath must match the std430 layout of Path");
+static_assert(sizeof(WavefrontQueueState) == 124, "WavefrontQueueState must match the std430 layout of QueueState");
+
+// Path tracer split into compute kernels that communicate through queues in storage buffers:
+// generate camera rays, intersect them, then shade each material queue in its own dispatch.
+// Threads of a dispatch run the same material code instead of diverging on every bounce like the fragment shader.
+// Queue lengths never leave the GPU, the dispatches after the first are sized indirectly.
+// Optionally the rays shading queues are binned by the octant of their direction before they are intersected
+class WavefrontPipeline {
+private:
+    std::unordered_map<std::string, std::unique_ptr<Shader>> shaders;
+    std::unordered_map<std::string, GLuint> uniform_locations;
+    std::unordered_map<std::string, GLuint> buffers;
+    int path_capacity;
+    glm::vec3 sky_horizon;
+    glm::vec3 sky_zenith;
+    std::vector<int> lights;
+    bool sort_rays;
+    bool count_coherence;
+
+    void SetupShaders();
+    void Resize(int path_count);
+    void ResetQueues(int path_count);
+    void Prepare(int stage);
+public:
+    WavefrontPipeline();
+    ~WavefrontPipeline();
+
+    // Traces samples paths per pixel, one wave of paths per sample, leaving the summed radiance of each pixel on the GPU.
+    // The scene buffers, the ray counter and, for SamplerType::BlueNoise, the blue noise texture have to be bound already
+    void Trace(const Camera& camera, int width, int height, int samples, int sample_offset, unsigned int frame, int light_bounces, int roulette_depth, int object_count, SamplerType sampler);
+    // Draws the average of the traced samples into the bound framebuffer, alpha is blend_weight like the fragment path
+    void Resolve(int width, int samples, float blend_weight, GLuint quad_vao);
+    void Release();
+    void SetSky(const glm::vec3& horizon, const glm::vec3& zenith);
+    // Indices of the objects sampled as lights, from FindLights
+    void SetLights(const std::vector<int>& light_objects);
+    void SetRaySorting(bool sort);
+    // Counts how many rays are intersected right after one going into the same octant, which costs a little
+    void SetCoherenceCounting(bool count);
+    // Rays intersected and the coherent ones among them since the last read, then starts counting again. Waits for the GPU
+    void ReadCoherence(unsigned long long& rays, unsigned long long& coherent_rays);
+
+    // Getters
+    int GetLiveObjectCount() const;
+};
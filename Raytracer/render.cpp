@@ -0,0 +1,527 @@
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./include/OffscreenContext.h"
+#include "./include/Renderer.h"
+#include "./include/Camera.h"
+#include "./include/Scene.h"
+#include "./include/Image.h"
+#include "./include/CPURenderer.h"
+#include "./include/RandomTests.h"
+#include "./include/FurnaceTests.h"
+
+// raytracer-render: renders a single image without opening a window.
+// Shaders are loaded from shaders/, so run it from the Raytracer directory like the interactive build
+
+static void PrintUsage() {
+    std::cout << "Usage: raytracer-render [options]\n"
+        << "  --scene <preset1|preset2|furnace|lights|instances|file> scene to render (default preset1)\n"
+        << "  --seed <n>                       seed for preset2 and instances (default 0)\n"
+        << "  --width <n> --height <n>         image size (default 1280x800)\n"
+        << "  --spp <n>                        samples per pixel (default 256)\n"
+        << "  --spp-per-pass <n>               samples traced per draw call (default 16)\n"
+        << "  --bounces <n>                    max light bounces (default 20)\n"
+        << "  --roulette-depth <n>             bounces before russian roulette may end a path, -1 turns it off (default 3)\n"
+        << "  --look-from <x,y,z>              camera position, overrides the scene\n"
+        << "  --look-at <x,y,z>                camera target, overrides the scene\n"
+        << "  --vfov <degrees>                 vertical field of view, overrides the scene\n"
+        << "  --tonemapper <none|reinhard|aces>\n"
+        << "  --exposure <ev> --gamma <g>      display transform (default 0 and 2.2)\n"
+        << "  --output <file.ppm|file.pfm>     PFM keeps the linear radiance (default render.ppm)\n"
+        << "  --backend <gpu|cpu|compare>      compare renders on both and checks that they agree (default gpu)\n"
+        << "  --pipeline <fragment|wavefront>  GPU path tracer, one fragment shader or compute kernels with material queues (default fragment)\n"
+        << "  --sampler <random|sobol|bluenoise> source of the sample dimensions (default random)\n"
+        << "  --sort-rays <on|off>             bins rays by direction and material between bounces on the CPU and in the wavefront\n"
+        << "                                   pipeline, the image stays the same (default off)\n"
+        << "  --benchmark <pipelines|sampling|bvh|spheres|threads|materials|sorting>\n"
+        << "                                   pipelines times both GPU pipelines on the presets at the image size and\n"
+        << "                                   --spp-per-pass, sampling prints the RMSE of every sampler against a --spp reference on\n"
+        << "                                   --backend, bvh times refitting the BVH of moving objects against building it again,\n"
+        << "                                   spheres times the SIMD sphere test against a scalar loop, threads times CPU renders of\n"
+        << "                                   the presets from 1 to --threads threads and several tile sizes, materials times\n"
+        << "                                   scattering by a switch against std::visit, sorting times preset 2 with and without\n"
+        << "                                   --sort-rays on --backend and prints the ray coherence, instead of rendering\n"
+        << "  --test <rng|furnace>             runs the statistical tests of the random number generator, or checks that diffuse\n"
+        << "                                   scattering conserves energy under analytic skies, instead of rendering\n"
+        << "  --threads <n>                    CPU threads, 0 uses all of them (default 0)\n"
+        << "  --tile-size <n>                  edge of the tiles the CPU threads share out, in pixels (default 16)\n"
+        << "  --tolerance <t>                  largest relative difference of the channel means for compare (default 0.02)\n";
+}
+
+static bool ParseVec3(const std::string& text, glm::vec3& value) {
+    std::istringstream stream(text);
+    char separator1, separator2;
+    return static_cast<bool>(stream >> value.x >> separator1 >> value.y >> separator2 >> value.z) && separator1 == ',' && separator2 == ',';
+}
+
+// Renders a scene with a sampler, samples per pixel and frame, returns the radiance
+typedef std::function<std::vector<float>(const Scene&, SamplerType, int, unsigned int)> RenderFunction;
+
+static double RMSE(const std::vector<float>& a, const std::vector<float>& b) {
+    double squared_error = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        squared_error += (a[i] - b[i]) * (a[i] - b[i]);
+    }
+    return std::sqrt(squared_error / a.size());
+}
+
+static void RunSamplingBenchmark(const RenderFunction& render, int reference_samples, unsigned int seed) {
+    const std::pair<std::string, Scene> scenes[] = { { "preset1", CreatePreset1() }, { "preset2", CreatePreset2(seed) } };
+    const SamplerType samplers[] = { SamplerType::Random, SamplerType::Sobol, SamplerType::BlueNoise };
+    for (const auto& scene : scenes) {
+        // Traced in another frame than the measured images, so its noise is independent of theirs
+        std::vector<float> reference = render(scene.second, SamplerType::Random, reference_samples, 1);
+        std::cout << scene.first << ", RMSE against a " << reference_samples << " spp reference" << std::endl;
+        std::cout << "    spp      Random       Sobol  Blue noise" << std::endl;
+        for (int samples = 1; samples <= std::max(1, reference_samples / 16); samples *= 2) {
+            std::cout << std::setw(7) << samples;
+            for (SamplerType sampler : samplers) {
+                std::cout << std::setw(12) << std::fixed << std::setprecision(5) << RMSE(render(scene.second, sampler, samples, 0), reference);
+            }
+            std::cout << std::endl;
+        }
+    }
+}
+
+// Moves the objects of preset 2 and the instances preset like dragging one of them or animating all of them would, and
+// times refitting the BVH every step against building it again
+static void RunBVHBenchmark(unsigned int seed) {
+    const std::pair<std::string, Scene> scenes[] = { { "preset2", CreatePreset2(seed) }, { "instances", CreateInstancesPreset(seed) } };
+    const int steps = 200;
+    std::cout << "scene      motion    refit ms  rebuild ms  rebuilds  growth" << std::endl;
+    for (const auto& scene : scenes) {
+        for (bool animate : { false, true }) {
+            // The ground is the first object and stays where it is
+            std::vector<Object> objects = scene.second.objects;
+            std::vector<std::pair<size_t, size_t>> ranges = { { 1, animate ? objects.size() : 2 } };
+            std::mt19937 gen(seed);
+            std::uniform_real_distribution<float> offset(-0.02f, 0.02f);
+            BVH refitted;
+            BVH rebuilt;
+            refitted.Build(objects, scene.second.meshes);
+            double refit_ms = 0;
+            double rebuild_ms = 0;
+            int fallbacks = 0;
+            for (int step = 0; step < steps; ++step) {
+                for (size_t i = ranges[0].first; i < ranges[0].second; ++i) {
+                    objects[i].position += animate ? glm::vec3(offset(gen), offset(gen), offset(gen)) : glm::vec3(0.02f, 0, 0);
+                }
+                auto start = std::chrono::high_resolution_clock::now();
+                if (!refitted.Refit(objects, scene.second.meshes, ranges)) {
+                    refitted.Build(objects, scene.second.meshes);
+                    ++fallbacks;
+                }
+                auto middle = std::chrono::high_resolution_clock::now();
+                rebuilt.Build(objects, scene.second.meshes);
+                auto end = std::chrono::high_resolution_clock::now();
+                refit_ms += std::chrono::duration<double, std::milli>(middle - start).count();
+                rebuild_ms += std::chrono::duration<double, std::milli>(end - middle).count();
+            }
+            std::cout << std::left << std::setw(11) << scene.first << std::setw(8) << (animate ? "animate" : "drag") << std::right << std::fixed
+                << std::setprecision(4) << std::setw(10) << refit_ms / steps << std::setw(12) << rebuild_ms / steps << std::setw(10) << fallbacks
+                << std::setprecision(2) << std::setw(8) << refitted.GetGrowth() << std::endl;
+        }
+    }
+}
+
+// Finds the nearest sphere of preset 2 along random rays from its camera, testing every sphere with HitSpheres and with
+// the scalar loop, and prints the rays per second of both
+static void RunSphereBenchmark(unsigned int seed) {
+    Scene scene = CreatePreset2(seed);
+    BVH bvh;
+    bvh.Build(scene.objects, scene.meshes);
+    SphereSoA spheres;
+    spheres.Build(scene.objects, bvh);
+    int sphere_count = static_cast<int>(bvh.GetPrimitiveIndices().size());
+
+    const int ray_count = 1 << 18;
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> spread(-0.25f, 0.25f);
+    std::vector<glm::vec3> directions(ray_count);
+    for (glm::vec3& direction : directions) {
+        direction = glm::normalize(scene.look_at - scene.look_from) + glm::vec3(spread(gen), spread(gen), spread(gen));
+    }
+
+    typedef void (*HitFunction)(const SphereSoA&, int, int, const glm::vec3&, const glm::vec3&, float, float, float*);
+    const std::pair<const char*, HitFunction> kernels[] = { { "scalar", HitSpheresScalar }, { "simd", HitSpheres } };
+    std::vector<float> nearest[2];
+    std::vector<float> t(sphere_count);
+    std::cout << sphere_count << " spheres, " << ray_count << " rays, " << SPHERE_LANES << " lanes" << std::endl;
+    for (int k = 0; k < 2; ++k) {
+        nearest[k].resize(ray_count);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int repeat = 0; repeat < 4; ++repeat) {
+            for (int ray = 0; ray < ray_count; ++ray) {
+                kernels[k].second(spheres, 0, sphere_count, scene.look_from, directions[ray], 0.001f, INFINITY, t.data());
+                float best = INFINITY;
+                for (int i = 0; i < sphere_count; ++i) {
+                    best = std::min(best, t[i]);
+                }
+                nearest[k][ray] = best;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << std::left << std::setw(8) << kernels[k].first << std::right << std::fixed << std::setprecision(1)
+            << std::setw(8) << 4 * ray_count / seconds / 1e6 << " M rays/s" << std::endl;
+    }
+    std::cout << (nearest[0] == nearest[1] ? "Both find the same hits" : "The kernels disagree") << std::endl;
+}
+
+// Renders both presets on the CPU with 1, 2, 4... up to thread_count threads and tiles of 8 to 64 pixels, and prints the
+// time, the speedup over one thread with the same tiles and how many tiles were stolen
+static void RunThreadBenchmark(int width, int height, int samples, int light_bounces, int roulette_depth, SamplerType sampler, int thread_count, unsigned int seed) {
+    const std::pair<std::string, Scene> scenes[] = { { "preset1", CreatePreset1() }, { "preset2", CreatePreset2(seed) } };
+    if (thread_count <= 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < thread_count; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(thread_count);
+    std::cout << "scene     tile  threads        ms  speedup  stolen" << std::endl;
+    for (const auto& scene : scenes) {
+        for (int tile_size : { 8, 16, 32, 64 }) {
+            double single_ms = 0;
+            for (int threads : thread_counts) {
+                CPURenderer cpu_renderer(light_bounces, threads, sampler, roulette_depth, tile_size);
+                auto start = std::chrono::high_resolution_clock::now();
+                cpu_renderer.Render(scene.second, width, height, samples);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                single_ms = threads == 1 ? ms : single_ms;
+                std::cout << std::left << std::setw(10) << scene.first << std::right << std::setw(4) << tile_size << std::setw(9) << threads
+                    << std::fixed << std::setprecision(1) << std::setw(10) << ms << std::setprecision(2) << std::setw(9) << single_ms / ms
+                    << std::setw(8) << cpu_renderer.GetStolenTiles() << std::endl;
+            }
+        }
+    }
+}
+
+// Preset 2 with and without ray sorting on the CPU. The rays that share a bin with the ray before them are counted as
+// they arrive at each stage and once sorted
+static void RunCPUSortingBenchmark(int width, int height, int samples, int light_bounces, int roulette_depth, SamplerType sampler, int thread_count, int tile_size, unsigned int seed) {
+    Scene scene = CreatePreset2(seed);
+    auto percent = [](long long part, long long whole) { return whole > 0 ? 100.0 * part / whole : 0.0; };
+    std::cout << "sorting         ms  octant coherent %  material coherent %" << std::endl;
+    std::vector<float> images[2];
+    for (int sort = 0; sort < 2; ++sort) {
+        CPURenderer cpu_renderer(light_bounces, thread_count, sampler, roulette_depth, tile_size);
+        cpu_renderer.SetRaySorting(sort != 0);
+        auto start = std::chrono::high_resolution_clock::now();
+        cpu_renderer.Render(scene, width, height, samples);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        images[sort] = cpu_renderer.ReadRadiance();
+        std::cout << std::left << std::setw(8) << (sort ? "on" : "off") << std::right << std::fixed << std::setprecision(1) << std::setw(9) << ms;
+        if (sort) {
+            RayCoherence coherence = cpu_renderer.GetRayCoherence();
+            std::cout << std::setw(9) << percent(coherence.octant_arrived, coherence.intersected) << " -> " << std::setw(5) << percent(coherence.octant_sorted, coherence.intersected)
+                << std::setw(12) << percent(coherence.material_arrived, coherence.shaded) << " -> " << std::setw(5) << percent(coherence.material_sorted, coherence.shaded);
+        }
+        std::cout << std::endl;
+    }
+    std::cout << (images[0] == images[1] ? "Both render the same image" : "Sorting changed the image") << std::endl;
+}
+
+static bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    std::string scene_name = "preset1";
+    std::string output = "render.ppm";
+    unsigned int seed = 0;
+    int width = 1280;
+    int height = 800;
+    int samples_per_pixel = 256;
+    int samples_per_pass = 16;
+    int light_bounces = 20;
+    int roulette_depth = 3;
+    bool has_look_from = false, has_look_at = false, has_vfov = false;
+    glm::vec3 look_from(0), look_at(0);
+    float vfov = 0;
+    Tonemapper tonemapper = Tonemapper::None;
+    float exposure = 0.0f;
+    float gamma = 2.2f;
+    std::string backend = "gpu";
+    int thread_count = 0;
+    int tile_size = CPU_TILE_SIZE;
+    float tolerance = 0.02f;
+    RenderPipeline pipeline = RenderPipeline::Fragment;
+    SamplerType sampler = SamplerType::Random;
+    std::string benchmark;
+    std::string test;
+    bool sort_rays = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option == "--help" || option == "-h") {
+            PrintUsage();
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << option << std::endl;
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        bool valid = true;
+        if (option == "--scene") scene_name = value;
+        else if (option == "--output") output = value;
+        else if (option == "--seed") seed = static_cast<unsigned int>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (option == "--width") width = std::atoi(value.c_str());
+        else if (option == "--height") height = std::atoi(value.c_str());
+        else if (option == "--spp") samples_per_pixel = std::atoi(value.c_str());
+        else if (option == "--spp-per-pass") samples_per_pass = std::atoi(value.c_str());
+        else if (option == "--bounces") light_bounces = std::atoi(value.c_str());
+        else if (option == "--roulette-depth") roulette_depth = std::atoi(value.c_str());
+        else if (option == "--look-from") valid = has_look_from = ParseVec3(value, look_from);
+        else if (option == "--look-at") valid = has_look_at = ParseVec3(value, look_at);
+        else if (option == "--vfov") { vfov = static_cast<float>(std::atof(value.c_str())); has_vfov = true; }
+        else if (option == "--exposure") exposure = static_cast<float>(std::atof(value.c_str()));
+        else if (option == "--gamma") gamma = static_cast<float>(std::atof(value.c_str()));
+        else if (option == "--backend") { backend = value; valid = backend == "gpu" || backend == "cpu" || backend == "compare"; }
+        else if (option == "--threads") thread_count = std::atoi(value.c_str());
+        else if (option == "--sort-rays") { sort_rays = value == "on"; valid = sort_rays || value == "off"; }
+        else if (option == "--tile-size") { tile_size = std::atoi(value.c_str()); valid = tile_size > 0; }
+        else if (option == "--tolerance") tolerance = static_cast<float>(std::atof(value.c_str()));
+        else if (option == "--test") { test = value; valid = test == "rng" || test == "furnace"; }
+        else if (option == "--benchmark") { benchmark = value; valid = benchmark == "pipelines" || benchmark == "sampling" || benchmark == "bvh" || benchmark == "spheres" || benchmark == "threads" || benchmark == "materials" || benchmark == "sorting"; }
+        else if (option == "--pipeline") {
+            if (value == "fragment") pipeline = RenderPipeline::Fragment;
+            else if (value == "wavefront") pipeline = RenderPipeline::Wavefront;
+            else valid = false;
+        }
+        else if (option == "--sampler") {
+            if (value == "random") sampler = SamplerType::Random;
+            else if (value == "sobol") sampler = SamplerType::Sobol;
+            else if (value == "bluenoise") sampler = SamplerType::BlueNoise;
+            else valid = false;
+        }
+        else if (option == "--tonemapper") {
+            if (value == "none") tonemapper = Tonemapper::None;
+            else if (value == "reinhard") tonemapper = Tonemapper::Reinhard;
+            else if (value == "aces") tonemapper = Tonemapper::ACES;
+            else valid = false;
+        }
+        else {
+            std::cerr << "Unknown option " << option << std::endl;
+            PrintUsage();
+            return EXIT_FAILURE;
+        }
+        if (!valid) {
+            std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (width <= 0 || height <= 0 || samples_per_pixel <= 0 || samples_per_pass <= 0 || light_bounces <= 0) {
+        std::cerr << "Size, samples and bounces must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!test.empty()) {
+        // Both run on the CPU alone, the comparisons with the shaders are skipped without a context
+        OffscreenContext context;
+        bool has_gl = context.Create();
+        GLenum glew_status = has_gl ? glewInit() : GLEW_OK;
+        if (has_gl && glew_status != GLEW_OK && glew_status != GLEW_ERROR_NO_GLX_DISPLAY) {
+            std::cerr << "Failed to initialize GLEW" << std::endl;
+            has_gl = false;
+        }
+        bool passed = test == "rng" ? RunRandomTests(has_gl) : RunFurnaceTests(has_gl);
+        return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (benchmark == "bvh") {
+        RunBVHBenchmark(seed);
+        return EXIT_SUCCESS;
+    }
+    if (benchmark == "spheres") {
+        RunSphereBenchmark(seed);
+        return EXIT_SUCCESS;
+    }
+    if (benchmark == "materials") {
+        return RunMaterialBenchmark(seed) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (benchmark == "threads") {
+        RunThreadBenchmark(width, height, samples_per_pixel, light_bounces, roulette_depth, sampler, thread_count, seed);
+        return EXIT_SUCCESS;
+    }
+
+    if (benchmark == "sorting" && backend == "cpu") {
+        RunCPUSortingBenchmark(width, height, samples_per_pixel, light_bounces, roulette_depth, sampler, thread_count, tile_size, seed);
+        return EXIT_SUCCESS;
+    }
+    if (benchmark == "sampling" && backend == "cpu") {
+        std::unique_ptr<CPURenderer> renderers[3];
+        RunSamplingBenchmark([&](const Scene& scene, SamplerType render_sampler, int samples, unsigned int frame) {
+            std::unique_ptr<CPURenderer>& cpu_renderer = renderers[static_cast<int>(render_sampler)];
+            if (!cpu_renderer) {
+                cpu_renderer = std::make_unique<CPURenderer>(light_bounces, thread_count, render_sampler, roulette_depth, tile_size);
+            }
+            cpu_renderer->Render(scene, width, height, samples, frame);
+            return cpu_renderer->ReadRadiance();
+        }, samples_per_pixel, seed);
+        return EXIT_SUCCESS;
+    }
+
+    if (!benchmark.empty()) {
+        OffscreenContext context;
+        if (!context.Create()) {
+            return EXIT_FAILURE;
+        }
+        auto camera = std::make_shared<Camera>();
+        Renderer renderer(nullptr, camera, light_bounces, samples_per_pass, 1.0f, false);
+        renderer.camera = camera;
+        renderer.SetRussianRoulette(roulette_depth);
+        if (benchmark == "sampling") {
+            renderer.SetPipeline(pipeline);
+            RunSamplingBenchmark([&](const Scene& scene, SamplerType render_sampler, int samples, unsigned int frame) {
+                renderer.ApplyScene(scene);
+                renderer.SetSampler(render_sampler);
+                renderer.RenderOffscreen(width, height, samples, frame);
+                return renderer.ReadRadiance(width, height);
+            }, samples_per_pixel, seed);
+        }
+        else if (benchmark == "sorting") {
+            // Only the wavefront pipeline has rays to sort, the count of coherent rays is of the rays it intersects
+            renderer.ApplyScene(CreatePreset2(seed));
+            renderer.SetPipeline(RenderPipeline::Wavefront);
+            renderer.SetSampler(sampler);
+            renderer.SetCoherenceCounting(true);
+            std::cout << "sorting         ms  octant coherent %" << std::endl;
+            for (int sort = 0; sort < 2; ++sort) {
+                renderer.SetRaySorting(sort != 0);
+                // The first pass compiles and uploads, it is left out of the time
+                renderer.RenderOffscreen(width, height, samples_per_pass);
+                unsigned long long rays = 0, coherent_rays = 0;
+                renderer.ReadRayCoherence(rays, coherent_rays);
+                auto start = std::chrono::high_resolution_clock::now();
+                renderer.RenderOffscreen(width, height, samples_per_pixel);
+                renderer.ReadRayCoherence(rays, coherent_rays);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                std::cout << std::left << std::setw(8) << (sort ? "on" : "off") << std::right << std::fixed << std::setprecision(1) << std::setw(9) << ms
+                    << std::setw(9) << (rays > 0 ? 100.0 * coherent_rays / rays : 0.0) << std::endl;
+            }
+        }
+        else {
+            renderer.RunPipelineBenchmark(width, height);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    Scene scene;
+    if (scene_name == "preset1") {
+        scene = CreatePreset1();
+    }
+    else if (scene_name == "preset2") {
+        scene = CreatePreset2(seed);
+    }
+    else if (scene_name == "furnace") {
+        scene = CreateFurnaceScene();
+    }
+    else if (scene_name == "lights") {
+        scene = CreateLightsPreset();
+    }
+    else if (scene_name == "instances") {
+        scene = CreateInstancesPreset(seed);
+    }
+    else if (!LoadScene(scene_name, scene)) {
+        return EXIT_FAILURE;
+    }
+    if (has_look_from) scene.look_from = look_from;
+    if (has_look_at) scene.look_at = look_at;
+    if (has_vfov) scene.vfov = vfov;
+
+    std::cout << "Rendering " << scene.objects.size() << " objects at " << width << "x" << height << ", " << samples_per_pixel << " spp on " << backend << std::endl;
+
+    std::vector<float> cpu_radiance;
+    if (backend != "gpu") {
+        CPURenderer cpu_renderer(light_bounces, thread_count, sampler, roulette_depth, tile_size);
+        cpu_renderer.SetRaySorting(sort_rays);
+        auto start = std::chrono::high_resolution_clock::now();
+        cpu_renderer.Render(scene, width, height, samples_per_pixel);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "CPU: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms on " << cpu_renderer.GetThreadCount() << " threads, "
+            << cpu_renderer.GetStolenTiles() << " tiles stolen" << std::endl;
+        cpu_radiance = cpu_renderer.ReadRadiance();
+    }
+
+    std::vector<float> gpu_radiance;
+    std::vector<unsigned char> gpu_pixels;
+    if (backend != "cpu") {
+        OffscreenContext context;
+        if (!context.Create()) {
+            return EXIT_FAILURE;
+        }
+        // The renderer frees its GL objects, so it has to go before the context does
+        auto camera = std::make_shared<Camera>();
+        Renderer renderer(nullptr, camera, light_bounces, samples_per_pass, 1.0f, false);
+        renderer.camera = camera;
+        renderer.ApplyScene(scene);
+        renderer.SetDisplaySettings(tonemapper, exposure, gamma);
+        renderer.SetPipeline(pipeline);
+        renderer.SetSampler(sampler);
+        renderer.SetRussianRoulette(roulette_depth);
+        renderer.SetRaySorting(sort_rays);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        renderer.RenderOffscreen(width, height, samples_per_pixel);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "GPU: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+        gpu_radiance = renderer.ReadRadiance(width, height);
+        gpu_pixels = renderer.ReadPixels(width, height);
+    }
+
+    int status = EXIT_SUCCESS;
+    if (backend == "compare") {
+        // Both sample the same estimator, so the image means should agree up to noise
+        double gpu_mean[3] = {}, cpu_mean[3] = {}, squared_error = 0;
+        for (size_t i = 0; i < gpu_radiance.size(); ++i) {
+            gpu_mean[i % 3] += gpu_radiance[i];
+            cpu_mean[i % 3] += cpu_radiance[i];
+            squared_error += (gpu_radiance[i] - cpu_radiance[i]) * (gpu_radiance[i] - cpu_radiance[i]);
+        }
+        size_t pixel_count = gpu_radiance.size() / 3;
+        for (int channel = 0; channel < 3; ++channel) {
+            gpu_mean[channel] /= pixel_count;
+            cpu_mean[channel] /= pixel_count;
+            double difference = std::abs(gpu_mean[channel] - cpu_mean[channel]) / std::max(cpu_mean[channel], 1e-6);
+            std::cout << "channel " << channel << ": gpu mean " << gpu_mean[channel] << ", cpu mean " << cpu_mean[channel] << ", relative difference " << difference << std::endl;
+            if (difference > tolerance) {
+                status = EXIT_FAILURE;
+            }
+        }
+        std::cout << "RMSE " << std::sqrt(squared_error / gpu_radiance.size()) << std::endl;
+        std::cout << (status == EXIT_SUCCESS ? "CPU and GPU agree" : "CPU and GPU differ") << std::endl;
+    }
+
+    // Compare writes the GPU image, it is the one under test
+    bool written;
+    if (EndsWith(output, ".pfm")) {
+        written = WritePFM(output, width, height, backend == "cpu" ? cpu_radiance : gpu_radiance);
+    }
+    else {
+        written = WritePPM(output, width, height, backend == "cpu" ? ApplyDisplayTransform(cpu_radiance, tonemapper, exposure, gamma) : gpu_pixels);
+    }
+    if (!written) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << output << std::endl;
+
+    return status;
+}
@@ -5,6 +5,28 @@ out vec4 FragColor;
 uniform sampler2D yourTexture;
 // Screen resolution uniform
 uniform vec2 screenResolution;
+// Display transform
+uniform int tonemapper;
+uniform float exposure;
+uniform float gamma;
+
+vec3 reinhard(vec3 color) {
+    return color / (1.0 + color);
+}
+
+vec3 aces(vec3 color) {
+    //Narkowicz's fit of the ACES filmic curve
+    const float a = 2.51;
+    const float b = 0.03;
+    const float c = 2.43;
+    const float d = 0.59;
+    const float e = 0.14;
+    return clamp((color * (a * color + b)) / (color * (c * color + d) + e), 0.0, 1.0);
+}
+
+vec3 gammaCorrect(vec3 color, float gamma) {
+    return pow(color, vec3(1.0 / gamma));
+}
 
 void main() {
     vec2 stretchedTexCoords = gl_FragCoord.xy / screenResolution;
@@ -12,6 +34,18 @@ void main() {
     // Sample the texture
     vec4 texColor = texture(yourTexture, stretchedTexCoords);
 
-    // Output the sampled color
-    FragColor = texColor;
+    // The ray tracer outputs linear HDR radiance
+    vec3 color = texColor.rgb * exp2(exposure);
+    switch (tonemapper) {
+        case 1:
+            color = reinhard(color);
+            break;
+        case 2:
+            color = aces(color);
+            break;
+        default:
+            color = clamp(color, 0.0, 1.0);
+            break;
+    }
+    FragColor = vec4(gammaCorrect(color, gamma), 1.0);
 }
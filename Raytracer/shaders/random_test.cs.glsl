@@ -0,0 +1,28 @@
+#version 430 core
+
+#include "raytracing_common.glsl"
+
+//writes the first draws of the generator for a block of pixels, RunRandomTests checks them against Random.cpp
+
+//matches RANDOM_TEST_DRAWS in RandomTests.h
+#define RANDOM_TEST_DRAWS 8
+
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 4) writeonly buffer Draws {
+    uint u_draws[];
+};
+
+uniform int u_width;
+uniform int u_sampleIndex;
+uniform uint u_frame;
+
+void main() {
+    int pixel = int(gl_GlobalInvocationID.x);
+    uint state = initRandom(uvec2(pixel % u_width, pixel / u_width), uint(u_sampleIndex), u_frame);
+    //raw bits, then one float to check the conversion too
+    for (int i = 0; i < RANDOM_TEST_DRAWS - 1; i++) {
+        u_draws[pixel * RANDOM_TEST_DRAWS + i] = pcgNext(state);
+    }
+    u_draws[pixel * RANDOM_TEST_DRAWS + RANDOM_TEST_DRAWS - 1] = floatBitsToUint(rand(state));
+}
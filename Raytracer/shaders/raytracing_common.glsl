@@ -0,0 +1,743 @@
+//shared by the fragment path tracer and the wavefront kernels, included after #version
+
+//matches MAX_LIGHT_COUNT in Scene.h
+#define MAX_LIGHT_COUNT 16
+//matches ObjectType and MaterialType in Object.h
+#define OBJECT_SPHERE 1
+#define OBJECT_QUAD 2
+#define OBJECT_MESH 3
+#define MATERIAL_LAMBERTIAN 1
+#define MATERIAL_METAL 2
+#define MATERIAL_DIELECTRIC 3
+#define MATERIAL_EMISSIVE 4
+//matches BVH_MAX_DEPTH in BVH.h
+#define BVH_STACK_SIZE 32
+//matches RAY_COUNTER_SLOTS in GPUTimer.h
+#define RAY_COUNTER_SLOTS 64
+//matches SamplerType in Enums.h
+#define SAMPLER_RANDOM 0
+#define SAMPLER_SOBOL 1
+#define SAMPLER_BLUE_NOISE 2
+//matches BLUE_NOISE_SIZE in BlueNoise.h
+#define BLUE_NOISE_SIZE 64
+
+struct Interval {
+    float min;
+    float max;
+};
+
+//lambertian diffuse
+//metal
+//dielectric
+//emissive, albedo is the emitted radiance
+//members are ordered to match GPUMaterial in SceneBuffer.h, two texels of u_materials
+struct Material {
+    vec3 albedo;
+    int type;
+    float fuzz;
+    float refraction_index;
+};
+
+//scale:
+//first represents radius of sphere
+//half size of a quad, 0 along the axis it faces
+//per axis scale of a mesh, applied before its rotation
+//members are ordered to match GPUObject in SceneBuffer.h (std430)
+struct Object {
+    vec3 position;
+    int type;
+    vec3 scale;
+    int material;       //index into u_materials
+    vec4 rotation;      //unit quaternion of a mesh, xyz then w
+    int mesh_root;      //first node of the mesh in u_meshNodes
+};
+
+//nodes are stored depth first, the left child of an interior node is the next node
+//members are ordered to match BVHNode in BVH.h (std430)
+struct BVHNode {
+    vec3 bounds_min;
+    int right_or_first;
+    vec3 bounds_max;
+    int count;
+};
+
+struct HitRecord {
+    vec3 p;
+    vec3 normal;
+    float t;
+    bool front_face;
+    Material material;
+    int object;
+};
+
+struct Ray {
+    vec3 origin;
+    vec3 direction;
+};
+
+layout(std430, binding = 0) readonly buffer SceneObjects {
+    Object u_objects[];
+};
+layout(std430, binding = 1) readonly buffer BVHNodes {
+    BVHNode u_bvhNodes[];
+};
+layout(std430, binding = 2) readonly buffer BVHPrimitives {
+    int u_bvhPrimitives[];
+};
+uniform int u_objectCount;
+//ray segments traced by this pass, spread over several counters so fragments rarely contend
+layout(std430, binding = 3) buffer RayCounter {
+    uint u_rayCounts[RAY_COUNTER_SLOTS];
+};
+//distinct materials of the objects, a texture since compute shaders only have 8 storage buffers. Matches MATERIAL_TEXTURE_UNIT in SceneBuffer.h
+layout(binding = 5) uniform isamplerBuffer u_materials;
+Material objectMaterial(int index) {
+    ivec4 low = texelFetch(u_materials, 2 * index);
+    ivec4 high = texelFetch(u_materials, 2 * index + 1);
+    return Material(intBitsToFloat(low.xyz), low.w, intBitsToFloat(high.x), intBitsToFloat(high.y));
+}
+
+const float INFINITY = float(1.0 / 0.0);
+const float PI = 3.1415926;
+
+//vector Functions
+float lengthSquared(vec3 v) {
+    return dot(v, v);
+}
+//rotates v by the unit quaternion q
+vec3 rotate(vec4 q, vec3 v) {
+    vec3 t = 2.0 * cross(q.xyz, v);
+    return v + q.w * t + cross(q.xyz, t);
+}
+//the axis a quad faces is the one without extent
+int quadAxis(vec3 half_size) {
+    return half_size.x == 0.0 ? 0 : (half_size.y == 0.0 ? 1 : 2);
+}
+
+// Interval Functions
+bool surrounds(Interval i, float x) {
+    return i.min < x && x < i.max;
+}
+
+//random number generation
+//PCG (RXS-M-XS variant), every sample carries its own state and each draw advances it.
+//Mirrored bit for bit by Random.cpp
+uint pcgNext(inout uint state) {
+    state = state * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+uint pcgHash(uint value) {
+    return pcgNext(value);
+}
+//hashing each input into the next keeps neighbouring pixels, samples and frames uncorrelated
+uint initRandom(uvec2 pixel, uint sample_index, uint frame) {
+    return pcgHash(pixel.x + pcgHash(pixel.y + pcgHash(sample_index + pcgHash(frame))));
+}
+//uniform in [0, 1), the top 24 bits are exact in a float
+float toUnitFloat(uint bits) {
+    return float(bits >> 8) * (1.0 / 16777216.0);
+}
+float rand(inout uint state) {
+    return toUnitFloat(pcgNext(state));
+}
+
+//sampling
+//a sample draws its dimensions in pairs, the camera jitter first and then two per bounce.
+//All backends are mirrored bit for bit by CPURenderer.cpp
+uniform int u_sampler;
+//ranks of a void and cluster pattern, from BlueNoise.cpp
+uniform usampler2D u_blueNoise;
+
+struct Sampler {
+    uvec2 pixel;
+    uint index;         //sample index within the pixel, accumulated passes continue the sequence
+    uint frame;
+    uint dimension;     //next dimension to draw
+    uint rng;           //PCG state of the random backend
+};
+
+Sampler initSampler(uvec2 pixel, uint sample_index, uint frame) {
+    Sampler s;
+    s.pixel = pixel;
+    s.index = sample_index;
+    s.frame = frame;
+    s.dimension = 0u;
+    s.rng = initRandom(pixel, sample_index, frame);
+    return s;
+}
+
+//base 2 Owen scrambling as a hash (Burley, Practical Hash-based Owen Scrambling)
+uint laineKarrasPermutation(uint x, uint seed) {
+    x ^= x * 0x3d20adeau;
+    x += seed;
+    x *= (seed >> 16) | 1u;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return x;
+}
+uint nestedUniformScramble(uint x, uint seed) {
+    return bitfieldReverse(laineKarrasPermutation(bitfieldReverse(x), seed));
+}
+//second Sobol dimension, the first is the bit reversed index
+uint sobol1(uint index) {
+    uint result = 0u;
+    for (uint v = 1u << 31; index != 0u; index >>= 1, v ^= v >> 1) {
+        if ((index & 1u) != 0u) {
+            result ^= v;
+        }
+    }
+    return result;
+}
+//every pair of dimensions is its own shuffled and scrambled 2D Sobol sequence, so bounces do not line up with each other
+vec2 sobol2D(Sampler s) {
+    uint seed = pcgHash(s.dimension + pcgHash(s.pixel.x + pcgHash(s.pixel.y + pcgHash(s.frame))));
+    uint index = nestedUniformScramble(s.index, seed);
+    uint x = nestedUniformScramble(bitfieldReverse(index), pcgHash(seed + 1u));
+    uint y = nestedUniformScramble(sobol1(index), pcgHash(seed + 2u));
+    return vec2(toUnitFloat(x), toUnitFloat(y));
+}
+//every dimension reads the blue noise tile at its own offset, successive samples step along the R2 sequence
+vec2 blueNoise2D(Sampler s) {
+    uint offset = pcgHash(s.dimension + pcgHash(s.frame));
+    uvec2 pixel_x = (s.pixel + uvec2(offset, offset >> 8)) % uint(BLUE_NOISE_SIZE);
+    uvec2 pixel_y = (s.pixel + uvec2(offset >> 16, offset >> 24)) % uint(BLUE_NOISE_SIZE);
+    //ranks fill the top 12 bits, the unsigned overflow of the R2 step is the wrap around of [0, 1)
+    uint x = (texelFetch(u_blueNoise, ivec2(pixel_x), 0).r << 20) + s.index * 3242174889u;
+    uint y = (texelFetch(u_blueNoise, ivec2(pixel_y), 0).r << 20) + s.index * 2447445414u;
+    return vec2(toUnitFloat(x), toUnitFloat(y));
+}
+vec2 sample2D(inout Sampler s) {
+    vec2 u;
+    if (u_sampler == SAMPLER_SOBOL) {
+        u = sobol2D(s);
+    }
+    else if (u_sampler == SAMPLER_BLUE_NOISE) {
+        u = blueNoise2D(s);
+    }
+    else {
+        u.x = rand(s.rng);
+        u.y = rand(s.rng);
+    }
+    s.dimension += 2u;
+    return u;
+}
+
+//uniform over the whole sphere
+vec3 randomUnitVector(inout Sampler s) {
+    vec2 u = sample2D(s);
+    float z = 1.0 - 2.0 * u.x;
+    float r = sqrt(max(0.0, 1.0 - z * z));
+    float phi = 2.0 * PI * u.y;
+    return vec3(r * cos(phi), r * sin(phi), z);
+}
+//around +z with a density of cos(theta) / PI, which cancels the cosine and 1 / PI of a lambertian surface
+vec3 cosineSampleHemisphere(vec2 u) {
+    float r = sqrt(u.x);
+    float phi = 2.0 * PI * u.y;
+    return vec3(r * cos(phi), r * sin(phi), sqrt(max(0.0, 1.0 - u.x)));
+}
+//columns are a tangent, a bitangent and the unit vector n (Duff et al., Building an Orthonormal Basis, Revisited)
+mat3 orthonormalBasis(vec3 n) {
+    float flip = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (flip + n.z);
+    float b = n.x * n.y * a;
+    vec3 tangent = vec3(1.0 + flip * n.x * n.x * a, flip * b, -flip * n.x);
+    vec3 bitangent = vec3(b, flip + n.y * n.y * a, -n.y);
+    return mat3(tangent, bitangent, n);
+}
+
+//background of rays that leave the scene, a vertical gradient
+uniform vec3 u_skyHorizon;
+uniform vec3 u_skyZenith;
+vec3 skyColor(vec3 direction) {
+    vec3 unit_direction = normalize(direction);
+    float a = 0.5 * (unit_direction.y + 1.0);
+    return (1.0 - a) * u_skyHorizon + a * u_skyZenith;
+}
+
+//russian roulette: after u_rouletteDepth bounces a path survives with the probability of its largest throughput
+//component and the survivors are weighted up by its inverse, so the expected radiance stays the same. Negative turns it off
+uniform int u_rouletteDepth;
+bool survivesRoulette(int depth, inout vec3 throughput, inout Sampler sampler) {
+    if (u_rouletteDepth < 0 || depth < u_rouletteDepth) {
+        return true;
+    }
+    float survival = min(max(throughput.r, max(throughput.g, throughput.b)), 1.0);
+    if (sample2D(sampler).x >= survival) {
+        return false;
+    }
+    throughput /= survival;
+    return true;
+}
+
+//material functions
+vec3 reflect(vec3 v, vec3 n) {
+    return v - 2*dot(v,n)*n;
+}
+vec3 refract(vec3 r_in, vec3 normal, float etaI_over_etaT) {
+    //snell's law
+    float cos_theta = min(1.0, dot(-r_in, normal));
+    vec3 r_out_perp = etaI_over_etaT * (r_in + cos_theta * normal);
+    vec3 r_out_parallel = -sqrt(abs(1.0-dot(r_out_perp, r_out_perp))) * normal;
+    return r_out_perp + r_out_parallel;
+}
+float reflectance(float cosine, float ref_idx) {
+    //schlick approximation
+    float r0 = (1-ref_idx) / (1+ref_idx);
+    r0 = r0*r0;
+    return r0 + (1-r0)*pow((1-cosine), 5);
+}
+bool scatter(Ray r_in, HitRecord rec, inout vec3 attenuation, inout Ray scattered, inout Sampler sampler) {
+    switch (rec.material.type) {
+        case 0: //unitialized
+            break;
+        case 1: //diffuse
+            //cosine weighted, so the weight of the bounce is just the albedo
+            vec3 scatter_direction = orthonormalBasis(rec.normal) * cosineSampleHemisphere(sample2D(sampler));
+            scattered.origin = rec.p;
+            scattered.direction = scatter_direction;
+            attenuation = rec.material.albedo;
+            break;
+        case 2: //metal
+            vec3 reflected = reflect(normalize(r_in.direction), rec.normal);
+            scattered.origin = rec.p;
+            scattered.direction = reflected+rec.material.fuzz*randomUnitVector(sampler);
+            attenuation = rec.material.albedo;
+            return (dot(scattered.direction, rec.normal) > 0);
+        case 3: //dielectric
+            attenuation = vec3(1.0);
+            float refraction_ratio = rec.front_face ? (1.0/rec.material.refraction_index) : rec.material.refraction_index;
+            vec3 unit_direction = normalize(r_in.direction);
+            vec3 refracted = refract(unit_direction, rec.normal, refraction_ratio);
+
+            float cos_theta = min(1.0, dot(-unit_direction, rec.normal));
+            float sin_theta = sqrt(1.0-cos_theta*cos_theta);
+
+            bool cannot_refract = refraction_ratio * sin_theta > 1.0;
+            vec3 direction; 
+
+            float reflect_prob = reflectance(cos_theta, refraction_ratio);
+
+            //a deterministic value makes the object more smooth. Randomness causes quite a bit of noise.
+            float random_val = 0.5;
+
+            if(cannot_refract || reflectance(cos_theta, refraction_ratio) > random_val) {
+                direction = reflect(unit_direction, rec.normal);
+            } else {
+                direction = refract(unit_direction, rec.normal, refraction_ratio);
+            }
+            scattered.origin = rec.p;
+            scattered.direction = direction;
+
+            break; 
+    }
+    return true;
+}
+
+// Ray Functions
+vec3 at(Ray r, float t) {
+    return r.origin + t * r.direction;
+}
+bool hitSphere(const vec3 center, float radius, const Ray r, Interval ray_t, inout HitRecord rec, Material material) {
+    vec3 oc = r.origin - center;
+    float a = dot(r.direction, r.direction);
+    float half_b = dot(oc, r.direction);
+    float c = dot(oc, oc) - radius * radius;
+    float discriminant = half_b * half_b - a * c;
+    if (discriminant < 0) {
+        return false;
+    }
+    float root = (-half_b - sqrt(discriminant)) / a;
+    if (!surrounds(ray_t, root)) {
+        root = (-half_b + sqrt(discriminant)) / a;
+        if (!surrounds(ray_t, root)) {
+            return false;
+        }
+    }
+    rec.t = root;
+    rec.p = at(r, rec.t);
+    vec3 outward_normal = (rec.p - center) / radius;
+    rec.front_face = dot(r.direction, outward_normal) < 0;
+    rec.normal = rec.front_face ? outward_normal : -outward_normal;
+    rec.material = material;
+    //rec.material.type = material.type;
+    //rec.material.albedo = ;
+    return true;
+}
+//axis aligned rectangle, hit from either side
+bool hitQuad(vec3 center, vec3 half_size, Ray r, Interval ray_t, inout HitRecord rec, Material material) {
+    int axis = quadAxis(half_size);
+    if (r.direction[axis] == 0.0) {
+        return false;
+    }
+    float t = (center[axis] - r.origin[axis]) / r.direction[axis];
+    if (!surrounds(ray_t, t)) {
+        return false;
+    }
+    vec3 p = at(r, t);
+    vec3 from_center = abs(p - center);
+    from_center[axis] = 0.0;
+    if (any(greaterThan(from_center, abs(half_size)))) {
+        return false;
+    }
+    rec.t = t;
+    rec.p = p;
+    vec3 outward_normal = vec3(0.0);
+    outward_normal[axis] = 1.0;
+    rec.front_face = dot(r.direction, outward_normal) < 0;
+    rec.normal = rec.front_face ? outward_normal : -outward_normal;
+    rec.material = material;
+    return true;
+}
+//returns the entry distance of the ray into the box, or INFINITY if it misses within [t_min, t_max]
+float hitAABB(vec3 bounds_min, vec3 bounds_max, Ray r, vec3 inv_direction, float t_min, float t_max) {
+    vec3 t0 = (bounds_min - r.origin) * inv_direction;
+    vec3 t1 = (bounds_max - r.origin) * inv_direction;
+    vec3 t_near = min(t0, t1);
+    vec3 t_far = max(t0, t1);
+    float t_enter = max(max(t_near.x, t_near.y), max(t_near.z, t_min));
+    float t_exit = min(min(t_far.x, t_far.y), min(t_far.z, t_max));
+    return t_enter <= t_exit ? t_enter : INFINITY;
+}
+
+//triangle meshes, all of them back to back with absolute indices, see SceneBuffer::UploadMeshes.
+//Bindings match the MESH_ texture units in SceneBuffer.h
+layout(binding = 2) uniform samplerBuffer u_meshVertices;   //position then normal of each vertex, the normal is 0 if the file had none
+layout(binding = 3) uniform isamplerBuffer u_meshTriangles; //vertex indices of each triangle
+layout(binding = 4) uniform isamplerBuffer u_meshNodes;     //BVHNode bit for bit, two texels each
+
+BVHNode meshNode(int index) {
+    ivec4 low = texelFetch(u_meshNodes, 2 * index);
+    ivec4 high = texelFetch(u_meshNodes, 2 * index + 1);
+    return BVHNode(intBitsToFloat(low.xyz), low.w, intBitsToFloat(high.xyz), high.w);
+}
+//watertight ray triangle test (Woop, Benthin and Wald 2013). The ray is permuted and sheared onto +z once per mesh, after
+//which both triangles along an edge evaluate it from the same two vertices, so a ray through the edge hits at least one of them
+struct TriangleRay {
+    ivec3 axes;     //the largest direction component goes last
+    vec3 shear;
+};
+TriangleRay initTriangleRay(vec3 direction) {
+    vec3 a = abs(direction);
+    int kz = a.x > a.y ? (a.x > a.z ? 0 : 2) : (a.y > a.z ? 1 : 2);
+    int kx = kz == 2 ? 0 : kz + 1;
+    int ky = kx == 2 ? 0 : kx + 1;
+    return TriangleRay(ivec3(kx, ky, kz), vec3(-direction[kx] / direction[kz], -direction[ky] / direction[kz], 1.0 / direction[kz]));
+}
+vec3 shearVertex(vec3 p, TriangleRay triangle_ray) {
+    vec3 q = vec3(p[triangle_ray.axes.x], p[triangle_ray.axes.y], p[triangle_ray.axes.z]);
+    return vec3(q.xy + triangle_ray.shear.xy * q.z, q.z * triangle_ray.shear.z);
+}
+//returns t and the weight of each vertex, or INFINITY on a miss. Triangles are hit from both sides
+float hitTriangle(vec3 p0, vec3 p1, vec3 p2, vec3 origin, TriangleRay triangle_ray, Interval ray_t, out vec3 barycentric) {
+    vec3 a = shearVertex(p0 - origin, triangle_ray);
+    vec3 b = shearVertex(p1 - origin, triangle_ray);
+    vec3 c = shearVertex(p2 - origin, triangle_ray);
+    //precise keeps the compiler from fusing the products differently for the two triangles of an edge
+    precise float e0 = b.x * c.y - b.y * c.x;
+    precise float e1 = c.x * a.y - c.y * a.x;
+    precise float e2 = a.x * b.y - a.y * b.x;
+    if ((e0 < 0.0 || e1 < 0.0 || e2 < 0.0) && (e0 > 0.0 || e1 > 0.0 || e2 > 0.0)) {
+        return INFINITY;
+    }
+    float det = e0 + e1 + e2;
+    if (det == 0.0) {
+        return INFINITY;
+    }
+    float t = (e0 * a.z + e1 * b.z + e2 * c.z) / det;
+    if (!surrounds(ray_t, t)) {
+        return INFINITY;
+    }
+    barycentric = vec3(e0, e1, e2) / det;
+    return t;
+}
+//traverses the BVH of the mesh with the ray in its object space, where t is the same as in the scene
+bool hitMesh(Object object, Ray r, Interval ray_t, inout HitRecord rec) {
+    vec4 inverse_rotation = vec4(-object.rotation.xyz, object.rotation.w);
+    Ray local = Ray(rotate(inverse_rotation, r.origin - object.position) / object.scale, rotate(inverse_rotation, r.direction) / object.scale);
+    vec3 inv_direction = 1.0 / local.direction;
+    TriangleRay triangle_ray = initTriangleRay(local.direction);
+    int hit_triangle = -1;
+    vec3 hit_barycentric = vec3(0.0);
+    float closest_so_far = ray_t.max;
+
+    int stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    int node_index = object.mesh_root;
+    BVHNode root = meshNode(node_index);
+    if (hitAABB(root.bounds_min, root.bounds_max, local, inv_direction, ray_t.min, closest_so_far) == INFINITY) {
+        return false;
+    }
+    while (true) {
+        BVHNode node = meshNode(node_index);
+        if (node.count > 0) {
+            for (int i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+                ivec3 triangle = texelFetch(u_meshTriangles, i).xyz;
+                vec3 barycentric;
+                float t = hitTriangle(texelFetch(u_meshVertices, 2 * triangle.x).xyz, texelFetch(u_meshVertices, 2 * triangle.y).xyz,
+                    texelFetch(u_meshVertices, 2 * triangle.z).xyz, local.origin, triangle_ray, Interval(ray_t.min, closest_so_far), barycentric);
+                if (t != INFINITY) {
+                    closest_so_far = t;
+                    hit_triangle = i;
+                    hit_barycentric = barycentric;
+                }
+            }
+        } else {
+            int near_child = node_index + 1;
+            int far_child = node.right_or_first;
+            BVHNode near_node = meshNode(near_child);
+            BVHNode far_node = meshNode(far_child);
+            float t_near = hitAABB(near_node.bounds_min, near_node.bounds_max, local, inv_direction, ray_t.min, closest_so_far);
+            float t_far = hitAABB(far_node.bounds_min, far_node.bounds_max, local, inv_direction, ray_t.min, closest_so_far);
+            if (t_far < t_near) {
+                int swap_child = near_child;
+                near_child = far_child;
+                far_child = swap_child;
+                float swap_t = t_near;
+                t_near = t_far;
+                t_far = swap_t;
+            }
+            if (t_near != INFINITY) {
+                if (t_far != INFINITY && stack_size < BVH_STACK_SIZE) {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    if (hit_triangle < 0) {
+        return false;
+    }
+
+    ivec3 triangle = texelFetch(u_meshTriangles, hit_triangle).xyz;
+    vec3 p0 = texelFetch(u_meshVertices, 2 * triangle.x).xyz;
+    vec3 p1 = texelFetch(u_meshVertices, 2 * triangle.y).xyz;
+    vec3 p2 = texelFetch(u_meshVertices, 2 * triangle.z).xyz;
+    vec3 normal = hit_barycentric.x * texelFetch(u_meshVertices, 2 * triangle.x + 1).xyz
+        + hit_barycentric.y * texelFetch(u_meshVertices, 2 * triangle.y + 1).xyz
+        + hit_barycentric.z * texelFetch(u_meshVertices, 2 * triangle.z + 1).xyz;
+    //normals scale by the inverse of the object scale, then rotate. Without vertex normals the counter clockwise side is outside
+    vec3 geometric_normal = normalize(rotate(object.rotation, cross(p1 - p0, p2 - p0) / object.scale));
+    normal = lengthSquared(normal) > 0.0 ? normalize(rotate(object.rotation, normal / object.scale)) : geometric_normal;
+    if (dot(geometric_normal, normal) < 0.0) {
+        geometric_normal = -geometric_normal;
+    }
+    rec.t = closest_so_far;
+    rec.p = at(r, rec.t);
+    rec.front_face = dot(r.direction, geometric_normal) < 0;
+    rec.normal = rec.front_face ? normal : -normal;
+    rec.material = objectMaterial(object.material);
+    return true;
+}
+bool hitObject(int object_index, Ray r, Interval ray_t, inout HitRecord rec) {
+    switch (u_objects[object_index].type) {
+        case 1:
+            if (hitSphere(u_objects[object_index].position, u_objects[object_index].scale.x, r, ray_t, rec, objectMaterial(u_objects[object_index].material))) {
+                rec.object = object_index;
+                return true;
+            }
+            return false;
+        case 2:
+            if (hitQuad(u_objects[object_index].position, u_objects[object_index].scale, r, ray_t, rec, objectMaterial(u_objects[object_index].material))) {
+                rec.object = object_index;
+                return true;
+            }
+            return false;
+        case 3:
+            if (hitMesh(u_objects[object_index], r, ray_t, rec)) {
+                rec.object = object_index;
+                return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+bool hit(Ray r, Interval ray_t, inout HitRecord rec) {
+    if (u_objectCount == 0) {
+        return false;
+    }
+    HitRecord temp_rec;
+    bool hit_anything = false;
+    float closest_so_far = ray_t.max;
+    vec3 inv_direction = 1.0 / r.direction;
+
+    //short stack traversal, the nearer child is visited first and the farther one is pushed
+    int stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    int node_index = 0;
+    if (hitAABB(u_bvhNodes[0].bounds_min, u_bvhNodes[0].bounds_max, r, inv_direction, ray_t.min, closest_so_far) == INFINITY) {
+        return false;
+    }
+    while (true) {
+        BVHNode node = u_bvhNodes[node_index];
+        if (node.count > 0) {
+            for (int i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+                if (hitObject(u_bvhPrimitives[i], r, Interval(ray_t.min, closest_so_far), temp_rec)) {
+                    hit_anything = true;
+                    closest_so_far = temp_rec.t;
+                    rec = temp_rec;
+                }
+            }
+        } else {
+            int near_child = node_index + 1;
+            int far_child = node.right_or_first;
+            float t_near = hitAABB(u_bvhNodes[near_child].bounds_min, u_bvhNodes[near_child].bounds_max, r, inv_direction, ray_t.min, closest_so_far);
+            float t_far = hitAABB(u_bvhNodes[far_child].bounds_min, u_bvhNodes[far_child].bounds_max, r, inv_direction, ray_t.min, closest_so_far);
+            if (t_far < t_near) {
+                int swap_child = near_child;
+                near_child = far_child;
+                far_child = swap_child;
+                float swap_t = t_near;
+                t_near = t_far;
+                t_far = swap_t;
+            }
+            if (t_near != INFINITY) {
+                if (t_far != INFINITY && stack_size < BVH_STACK_SIZE) {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    return hit_anything;
+}
+
+//lights: the emissive objects sampled directly, see FindLights in Scene.cpp
+uniform int u_lightCount;
+uniform int u_lights[MAX_LIGHT_COUNT];
+
+bool isSampledLight(int object) {
+    for (int i = 0; i < u_lightCount; i++) {
+        if (u_lights[i] == object) {
+            return true;
+        }
+    }
+    return false;
+}
+//spheres and meshes emit outwards, quads from both sides
+vec3 emitted(HitRecord rec) {
+    if (rec.material.type != MATERIAL_EMISSIVE || (!rec.front_face && u_objects[rec.object].type != OBJECT_QUAD)) {
+        return vec3(0.0);
+    }
+    return rec.material.albedo;
+}
+//1 - cos of the cone a sphere subtends, x is (radius / distance)^2. Avoids the cancellation of 1 - sqrt(1 - x) for small lights
+float coneSolidAngleFactor(float x) {
+    return x / (1.0 + sqrt(1.0 - x));
+}
+//solid angle density of sampleLight picking the direction from p to light_point on the light, 0 if it never does
+float lightPdf(int object, vec3 p, vec3 light_point) {
+    Object light = u_objects[object];
+    if (light.type == OBJECT_SPHERE) {
+        float radius_squared = light.scale.x * light.scale.x;
+        float distance_squared = lengthSquared(light.position - p);
+        if (distance_squared <= radius_squared) {
+            return 0.0;
+        }
+        return 1.0 / (2.0 * PI * coneSolidAngleFactor(radius_squared / distance_squared));
+    }
+    if (light.type == OBJECT_QUAD) {
+        int axis = quadAxis(light.scale);
+        vec3 to_light = light_point - p;
+        float distance_squared = lengthSquared(to_light);
+        float cosine = abs(to_light[axis]) / sqrt(distance_squared);
+        vec3 extent = abs(light.scale);
+        extent[axis] = 1.0;
+        float area = 4.0 * extent.x * extent.y * extent.z;
+        return cosine > 0.0 ? distance_squared / (area * cosine) : 0.0;
+    }
+    return 0.0;
+}
+//picks a unit direction from p towards the light, uniform over the cone of a sphere or the area of a quad
+bool sampleLight(int object, vec3 p, vec2 u, out vec3 direction, out float pdf) {
+    Object light = u_objects[object];
+    if (light.type == OBJECT_SPHERE) {
+        vec3 to_center = light.position - p;
+        float distance_squared = lengthSquared(to_center);
+        float radius_squared = light.scale.x * light.scale.x;
+        if (distance_squared <= radius_squared) {
+            return false;
+        }
+        float one_minus_cos_max = coneSolidAngleFactor(radius_squared / distance_squared);
+        float cos_theta = 1.0 - u.x * one_minus_cos_max;
+        float sin_theta = sqrt(max(0.0, 1.0 - cos_theta * cos_theta));
+        float phi = 2.0 * PI * u.y;
+        direction = orthonormalBasis(to_center / sqrt(distance_squared)) * vec3(cos(phi) * sin_theta, sin(phi) * sin_theta, cos_theta);
+        pdf = 1.0 / (2.0 * PI * one_minus_cos_max);
+        return true;
+    }
+    if (light.type == OBJECT_QUAD) {
+        //u spans the two axes with extent
+        int axis = quadAxis(light.scale);
+        vec2 v = 2.0 * u - 1.0;
+        vec3 offset = axis == 0 ? vec3(0.0, v.x, v.y) : (axis == 1 ? vec3(v.x, 0.0, v.y) : vec3(v.x, v.y, 0.0));
+        vec3 light_point = light.position + offset * light.scale;
+        pdf = lightPdf(object, p, light_point);
+        direction = normalize(light_point - p);
+        return pdf > 0.0;
+    }
+    return false;
+}
+//MIS weight of one of two strategies that sample the same light (Veach's power heuristic)
+float powerHeuristic(float pdf, float other_pdf) {
+    return (pdf * pdf) / (pdf * pdf + other_pdf * other_pdf);
+}
+//next event estimation at a lambertian hit: one shadow ray towards a light picked uniformly, weighted against scattering
+//into the same light. Returns the radiance reflected back along the incoming ray, rays counts the shadow ray
+vec3 sampleDirectLight(HitRecord rec, inout Sampler sampler, inout uint rays) {
+    if (u_lightCount == 0) {
+        return vec3(0.0);
+    }
+    //the dimension that picks the light is reused for the point on it
+    vec2 u = sample2D(sampler);
+    float scaled = u.x * float(u_lightCount);
+    int slot = min(int(scaled), u_lightCount - 1);
+    u.x = scaled - float(slot);
+    int light = u_lights[slot];
+
+    vec3 direction;
+    float light_pdf;
+    if (!sampleLight(light, rec.p, u, direction, light_pdf)) {
+        return vec3(0.0);
+    }
+    float cosine = dot(direction, rec.normal);
+    if (cosine <= 0.0) {
+        return vec3(0.0);
+    }
+    rays++;
+    HitRecord shadow;
+    if (!hit(Ray(rec.p, direction), Interval(0.001, INFINITY), shadow) || shadow.object != light) {
+        return vec3(0.0);
+    }
+    light_pdf /= float(u_lightCount);
+    float bsdf_pdf = cosine / PI;
+    //a lambertian surface reflects albedo / PI of the incoming radiance
+    return emitted(shadow) * rec.material.albedo * (cosine / PI) * powerHeuristic(light_pdf, bsdf_pdf) / light_pdf;
+}
+//density of the direction a bounce scattered in, 0 for the specular materials whose direction lights cannot be sampled in
+float scatterPdf(HitRecord rec, Ray scattered) {
+    if (rec.material.type != MATERIAL_LAMBERTIAN) {
+        return 0.0;
+    }
+    return max(dot(normalize(scattered.direction), rec.normal), 0.0) / PI;
+}
+//MIS weight of a light that a bounce from origin scattered into with density bsdf_pdf. A density of 0 marks the camera ray
+//and specular bounces, where the light was not sampled directly and scattering carries all of it
+float emissionWeight(HitRecord rec, vec3 origin, float bsdf_pdf) {
+    if (bsdf_pdf == 0.0 || !isSampledLight(rec.object)) {
+        return 1.0;
+    }
+    return powerHeuristic(bsdf_pdf, lightPdf(rec.object, origin, rec.p) / float(u_lightCount));
+}
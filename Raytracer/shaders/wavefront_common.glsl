@@ -0,0 +1,64 @@
+//shared by the wavefront kernels, included after #version
+
+//matches WAVEFRONT_GROUP_SIZE in WavefrontPipeline.h
+#define WAVEFRONT_GROUP_SIZE 64
+//one queue per material type that scatters: lambertian, metal, dielectric
+#define MATERIAL_QUEUE_COUNT 3
+//the two ray queues come first in the queue buffer, then the material queues
+#define MATERIAL_QUEUE_BASE 2
+//with u_sortRays, shading queues the next rays here and the sort kernel bins them into the next ray queue
+#define SORT_QUEUE (MATERIAL_QUEUE_BASE + MATERIAL_QUEUE_COUNT)
+//one bin per sign combination of the ray direction
+#define OCTANT_COUNT 8
+
+//a path in flight, there is one per pixel and it is indexed by the pixel
+//members are ordered to match WavefrontPath in WavefrontPipeline.h (std430)
+struct Path {
+    vec3 origin;
+    int depth;
+    vec3 direction;
+    uint rng;           //sampler state of the sample, see initSampler
+    vec3 throughput;
+    int object;         //object hit by the last intersection
+    vec3 hit_point;
+    int front_face;
+    vec3 normal;
+    uint dimension;
+    float bsdf_pdf;     //density the ray was scattered with, see emissionWeight
+    float padding[3];
+};
+
+layout(std430, binding = 4) buffer Paths {
+    Path u_paths[];
+};
+//summed radiance of the samples traced so far in this pass
+layout(std430, binding = 5) buffer Radiance {
+    vec4 u_radiance[];
+};
+//path indices, u_pathCount entries per queue
+layout(std430, binding = 6) buffer Queues {
+    int u_queues[];
+};
+//queue lengths and the indirect dispatch arguments derived from them, one (x, y, z, unused) per queue
+layout(std430, binding = 7) buffer QueueState {
+    uvec4 u_dispatch[1 + MATERIAL_QUEUE_COUNT];
+    uint u_rayCount;
+    uint u_nextRayCount;
+    uint u_materialCounts[MATERIAL_QUEUE_COUNT];
+    //rays per octant queued by shading, turned into the start of each bin and then its fill position for the sort kernel
+    uint u_octantCounts[OCTANT_COUNT];
+    //rays intersected, and how many of them went into the same octant as the ray before them in the queue
+    uint u_intersectedRays;
+    uint u_coherentRays;
+};
+uniform int u_pathCount;
+//the ray queue being intersected, 0 or 1, shading fills the other one and they swap every bounce
+uniform int u_rayQueue;
+
+int queueEntry(int queue, uint index) {
+    return queue * u_pathCount + int(index);
+}
+
+int directionOctant(vec3 direction) {
+    return (direction.x < 0.0 ? 1 : 0) + (direction.y < 0.0 ? 2 : 0) + (direction.z < 0.0 ? 4 : 0);
+}
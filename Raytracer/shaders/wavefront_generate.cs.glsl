@@ -0,0 +1,49 @@
+#version 430 core
+
+#include "raytracing_common.glsl"
+#include "wavefront_common.glsl"
+
+//starts one camera path per pixel, sampled exactly like getRay in raytracing.fs.glsl
+
+layout(local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+uniform vec3 u_pixel00;
+uniform vec3 u_pixelDeltaU;
+uniform vec3 u_pixelDeltaV;
+uniform vec3 u_cameraCenter;
+uniform int u_width;
+
+uniform uint u_frame;
+uniform int u_sampleOffset;
+uniform int u_sampleIndex;
+
+void main() {
+    int pixel = int(gl_GlobalInvocationID.x);
+    if (pixel >= u_pathCount) {
+        return;
+    }
+    //gl_FragCoord of the pixel in the fragment path is its centre
+    vec2 frag_coord = vec2(pixel % u_width, pixel / u_width) + 0.5;
+    Sampler sampler = initSampler(uvec2(frag_coord), uint(u_sampleOffset + u_sampleIndex), u_frame);
+
+    vec2 jitter = sample2D(sampler);
+    float px = jitter.x - 0.5;
+    float py = jitter.y - 0.5;
+    vec3 pixel_center = u_pixel00 + (frag_coord.x * u_pixelDeltaU) + (frag_coord.y * u_pixelDeltaV);
+    vec3 pixel_sample = pixel_center + (px * u_pixelDeltaU) + (py * u_pixelDeltaV);
+
+    Path path;
+    path.origin = u_cameraCenter;
+    path.depth = 0;
+    path.direction = pixel_sample - u_cameraCenter;
+    path.rng = sampler.rng;
+    path.throughput = vec3(1.0);
+    path.object = -1;
+    path.hit_point = vec3(0.0);
+    path.front_face = 0;
+    path.normal = vec3(0.0);
+    path.dimension = sampler.dimension;
+    path.bsdf_pdf = 0.0;
+    u_paths[pixel] = path;
+    u_queues[queueEntry(u_rayQueue, uint(pixel))] = pixel;
+}
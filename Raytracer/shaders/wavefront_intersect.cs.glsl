@@ -0,0 +1,64 @@
+#version 430 core
+
+#include "raytracing_common.glsl"
+#include "wavefront_common.glsl"
+
+//traces every ray in the ray queue, misses pick up the sky, lights end their path and other hits are sorted into the queue of their material
+
+layout(local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+uniform bool u_countCoherence;
+
+shared uint group_ray_count;
+shared uint group_coherent_count;
+
+void main() {
+    if (gl_LocalInvocationIndex == 0) {
+        group_ray_count = 0u;
+        group_coherent_count = 0u;
+    }
+    barrier();
+
+    uint index = gl_GlobalInvocationID.x;
+    if (index < u_rayCount) {
+        int path_index = u_queues[queueEntry(u_rayQueue, index)];
+        Ray r = Ray(u_paths[path_index].origin, u_paths[path_index].direction);
+        atomicAdd(group_ray_count, 1u);
+        if (u_countCoherence && index > 0u) {
+            int previous = u_queues[queueEntry(u_rayQueue, index - 1u)];
+            if (directionOctant(u_paths[previous].direction) == directionOctant(r.direction)) {
+                atomicAdd(group_coherent_count, 1u);
+            }
+        }
+
+        HitRecord rec;
+        if (hit(r, Interval(0.001, INFINITY), rec)) {
+            if (rec.material.type == MATERIAL_EMISSIVE) {
+                u_radiance[path_index].rgb += u_paths[path_index].throughput * emitted(rec) * emissionWeight(rec, r.origin, u_paths[path_index].bsdf_pdf);
+            } else {
+                u_paths[path_index].object = rec.object;
+                u_paths[path_index].hit_point = rec.p;
+                u_paths[path_index].normal = rec.normal;
+                u_paths[path_index].front_face = rec.front_face ? 1 : 0;
+                //an uninitialised material does not scatter, the path ends without adding anything
+                int queue = rec.material.type - 1;
+                if (queue >= 0 && queue < MATERIAL_QUEUE_COUNT) {
+                    uint slot = atomicAdd(u_materialCounts[queue], 1u);
+                    u_queues[queueEntry(MATERIAL_QUEUE_BASE + queue, slot)] = path_index;
+                }
+            }
+        } else {
+            u_radiance[path_index].rgb += u_paths[path_index].throughput * skyColor(r.direction);
+        }
+    }
+
+    //one global atomic per group for the ray counter
+    barrier();
+    if (gl_LocalInvocationIndex == 0) {
+        atomicAdd(u_rayCounts[gl_WorkGroupID.x % RAY_COUNTER_SLOTS], group_ray_count);
+        if (u_countCoherence) {
+            atomicAdd(u_intersectedRays, group_ray_count);
+            atomicAdd(u_coherentRays, group_coherent_count);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#version 430 core
+
+#include "wavefront_common.glsl"
+
+//turns queue lengths into indirect dispatch arguments so the CPU never reads them back
+
+layout(local_size_x = 1) in;
+
+//0: start of a wave, every pixel has a camera ray queued
+//1: after intersection, sizes the material queues
+//2: after shading, the next ray queue becomes the ray queue and the octant counts become where each bin starts
+uniform int u_stage;
+
+uvec4 groupsFor(uint count) {
+    return uvec4((count + WAVEFRONT_GROUP_SIZE - 1) / WAVEFRONT_GROUP_SIZE, 1, 1, 0);
+}
+
+void main() {
+    if (u_stage == 1) {
+        for (int i = 0; i < MATERIAL_QUEUE_COUNT; i++) {
+            u_dispatch[1 + i] = groupsFor(u_materialCounts[i]);
+        }
+        for (int i = 0; i < OCTANT_COUNT; i++) {
+            u_octantCounts[i] = 0u;
+        }
+        return;
+    }
+    if (u_stage == 2) {
+        uint start = 0u;
+        for (int i = 0; i < OCTANT_COUNT; i++) {
+            uint count = u_octantCounts[i];
+            u_octantCounts[i] = start;
+            start += count;
+        }
+    }
+    u_rayCount = u_stage == 0 ? uint(u_pathCount) : u_nextRayCount;
+    u_nextRayCount = 0u;
+    for (int i = 0; i < MATERIAL_QUEUE_COUNT; i++) {
+        u_materialCounts[i] = 0u;
+    }
+    u_dispatch[0] = groupsFor(u_rayCount);
+}
@@ -0,0 +1,16 @@
+#version 430 core
+
+#include "wavefront_common.glsl"
+
+//writes the average of the traced samples like raytracing.fs.glsl, alpha is their weight when accumulating
+
+out vec4 FragColor;
+
+uniform int u_width;
+uniform int u_samplesPerPixel;
+uniform float u_blendWeight;
+
+void main() {
+    int pixel = int(gl_FragCoord.y) * u_width + int(gl_FragCoord.x);
+    FragColor = vec4(u_radiance[pixel].rgb / float(u_samplesPerPixel), u_blendWeight);
+}
@@ -0,0 +1,81 @@
+#version 430 core
+
+#include "raytracing_common.glsl"
+#include "wavefront_common.glsl"
+
+//scatters the paths in one material queue, so every thread of a dispatch takes the same branch in scatter()
+
+layout(local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+uniform int u_materialQueue;
+uniform int u_lightBounces;
+uniform int u_width;
+uniform int u_sampleOffset;
+uniform int u_sampleIndex;
+uniform uint u_frame;
+uniform bool u_sortRays;
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= u_materialCounts[u_materialQueue]) {
+        return;
+    }
+    int path_index = u_queues[queueEntry(MATERIAL_QUEUE_BASE + u_materialQueue, index)];
+    Path path = u_paths[path_index];
+
+    HitRecord rec;
+    rec.p = path.hit_point;
+    rec.normal = path.normal;
+    rec.t = 0.0;
+    rec.front_face = path.front_face != 0;
+    rec.material = objectMaterial(u_objects[path.object].material);
+    rec.object = path.object;
+
+    //the sampler of the path's sample, continued where the last bounce left it
+    Sampler sampler = initSampler(uvec2(path_index % u_width, path_index / u_width), uint(u_sampleOffset + u_sampleIndex), u_frame);
+    sampler.rng = path.rng;
+    sampler.dimension = path.dimension;
+
+    //the shadow ray is traced right here instead of going through a queue of its own
+    if (rec.material.type == MATERIAL_LAMBERTIAN) {
+        uint shadow_rays = 0u;
+        u_radiance[path_index].rgb += path.throughput * sampleDirectLight(rec, sampler, shadow_rays);
+        if (shadow_rays > 0u) {
+            atomicAdd(u_rayCounts[index % RAY_COUNTER_SLOTS], shadow_rays);
+        }
+    }
+
+    //the same rules as getRayColor: a path that stops scattering or runs out of bounces keeps its throughput
+    Ray scattered;
+    vec3 attenuation;
+    if (!scatter(Ray(path.origin, path.direction), rec, attenuation, scattered, sampler)) {
+        u_radiance[path_index].rgb += path.throughput;
+        return;
+    }
+    path.throughput *= attenuation;
+    path.bsdf_pdf = scatterPdf(rec, scattered);
+    path.depth++;
+    //a path ended by roulette adds nothing
+    if (!survivesRoulette(path.depth, path.throughput, sampler)) {
+        return;
+    }
+    if (path.depth >= u_lightBounces) {
+        u_radiance[path_index].rgb += path.throughput;
+        return;
+    }
+
+    u_paths[path_index].origin = scattered.origin;
+    u_paths[path_index].direction = scattered.direction;
+    u_paths[path_index].throughput = path.throughput;
+    u_paths[path_index].depth = path.depth;
+    u_paths[path_index].rng = sampler.rng;
+    u_paths[path_index].dimension = sampler.dimension;
+    u_paths[path_index].bsdf_pdf = path.bsdf_pdf;
+    uint slot = atomicAdd(u_nextRayCount, 1u);
+    if (u_sortRays) {
+        atomicAdd(u_octantCounts[directionOctant(scattered.direction)], 1u);
+        u_queues[queueEntry(SORT_QUEUE, slot)] = path_index;
+    } else {
+        u_queues[queueEntry(1 - u_rayQueue, slot)] = path_index;
+    }
+}
@@ -0,0 +1,18 @@
+#version 430 core
+
+#include "wavefront_common.glsl"
+
+//bins the rays queued by shading by the octant of their direction into the next ray queue, so neighbouring threads of
+//the next intersection walk the BVH in the same order. Rays within a bin keep no particular order
+
+layout(local_size_x = WAVEFRONT_GROUP_SIZE) in;
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= u_rayCount) {
+        return;
+    }
+    int path_index = u_queues[queueEntry(SORT_QUEUE, index)];
+    uint slot = atomicAdd(u_octantCounts[directionOctant(u_paths[path_index].direction)], 1u);
+    u_queues[queueEntry(u_rayQueue, slot)] = path_index;
+}
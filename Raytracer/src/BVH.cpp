@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/BVH.h"
+#include "../include/Mesh.h"
+
+#define BVH_BIN_COUNT 12
+#define BVH_MAX_LEAF_SIZE 8
+#define QUAD_BOUNDS_PADDING 1e-4f
+
+// Relative costs of visiting a node and of intersecting a primitive for the SAH
+const float TRAVERSAL_COST = 1.0f;
+const float INTERSECTION_COST = 1.0f;
+
+static float SurfaceArea(const glm::vec3& bounds_min, const glm::vec3& bounds_max) {
+    glm::vec3 extent = glm::max(bounds_max - bounds_min, glm::vec3(0.0f));
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// Bounds of an object in the scene, false for objects the BVH leaves out
+static bool ObjectBounds(const Object& object, const std::vector<std::shared_ptr<const Mesh>>& meshes, glm::vec3& bounds_min, glm::vec3& bounds_max) {
+    switch (object.type) {
+    case ObjectType::Sphere: {
+        // Negative radii are used for hollow spheres
+        glm::vec3 radius(std::abs(object.scale.x));
+        bounds_min = object.position - radius;
+        bounds_max = object.position + radius;
+        return true;
+    }
+    case ObjectType::Quad: {
+        // Padded along the axis it faces, a box without thickness can make the slab test divide 0 by 0
+        glm::vec3 half_size = glm::max(glm::abs(object.scale), glm::vec3(QUAD_BOUNDS_PADDING));
+        bounds_min = object.position - half_size;
+        bounds_max = object.position + half_size;
+        return true;
+    }
+    case ObjectType::Mesh: {
+        if (object.mesh < 0 || object.mesh >= static_cast<int>(meshes.size()) || meshes[object.mesh]->triangles.empty()) {
+            return false;
+        }
+        // Bounds of the eight corners of the mesh bounds, moved into the scene
+        const BVHNode& root = meshes[object.mesh]->bvh.GetNodes()[0];
+        glm::quat rotation = InstanceRotation(object);
+        bounds_min = glm::vec3(INFINITY);
+        bounds_max = glm::vec3(-INFINITY);
+        for (int corner = 0; corner < 8; ++corner) {
+            glm::vec3 local((corner & 1) ? root.bounds_max.x : root.bounds_min.x, (corner & 2) ? root.bounds_max.y : root.bounds_min.y, (corner & 4) ? root.bounds_max.z : root.bounds_min.z);
+            glm::vec3 world = object.position + rotation * (object.scale * local);
+            bounds_min = glm::min(bounds_min, world);
+            bounds_max = glm::max(bounds_max, world);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// What a node adds to the SAH cost for every unit of its area
+static float NodeCostWeight(const BVHNode& node) {
+    return node.count > 0 ? INTERSECTION_COST * node.count : TRAVERSAL_COST;
+}
+
+BVH::BVH() : weighted_growth{ 0.0 }, total_weight{ 0.0 } {}
+
+void BVH::Build(const std::vector<Object>& objects, const std::vector<std::shared_ptr<const Mesh>>& meshes) {
+    build_primitives.clear();
+    primitive_bounds.assign(objects.size(), std::make_pair(glm::vec3(0.0f), glm::vec3(0.0f)));
+    for (size_t i = 0; i < objects.size(); ++i) {
+        glm::vec3 bounds_min, bounds_max;
+        if (ObjectBounds(objects[i], meshes, bounds_min, bounds_max)) {
+            build_primitives.push_back({ bounds_min, bounds_max, 0.5f * (bounds_min + bounds_max), static_cast<int>(i) });
+            primitive_bounds[i] = std::make_pair(bounds_min, bounds_max);
+        }
+    }
+    BuildPrimitives();
+
+    parents.assign(nodes.size(), -1);
+    primitive_leaves.assign(objects.size(), -1);
+    build_areas.resize(nodes.size());
+    refit_marks.assign(nodes.size(), 0);
+    weighted_growth = 0.0;
+    total_weight = 0.0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const BVHNode& node = nodes[i];
+        build_areas[i] = SurfaceArea(node.bounds_min, node.bounds_max);
+        weighted_growth += NodeCostWeight(node);
+        total_weight += NodeCostWeight(node);
+        if (node.count > 0) {
+            for (int j = node.right_or_first; j < node.right_or_first + node.count; ++j) {
+                primitive_leaves[primitive_indices[j]] = static_cast<int>(i);
+            }
+        }
+        else {
+            parents[i + 1] = static_cast<int>(i);
+            parents[node.right_or_first] = static_cast<int>(i);
+        }
+    }
+}
+
+void BVH::BuildTriangles(const std::vector<glm::vec3>& positions, const std::vector<glm::uvec3>& triangles) {
+    // Meshes never move, so nothing is kept for refitting
+    parents.clear();
+    primitive_leaves.clear();
+    primitive_bounds.clear();
+    build_areas.clear();
+    refit_marks.clear();
+    build_primitives.clear();
+    build_primitives.reserve(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        const glm::vec3& p0 = positions[triangles[i].x];
+        const glm::vec3& p1 = positions[triangles[i].y];
+        const glm::vec3& p2 = positions[triangles[i].z];
+        glm::vec3 bounds_min = glm::min(p0, glm::min(p1, p2));
+        glm::vec3 bounds_max = glm::max(p0, glm::max(p1, p2));
+        build_primitives.push_back({ bounds_min, bounds_max, 0.5f * (bounds_min + bounds_max), static_cast<int>(i) });
+    }
+    BuildPrimitives();
+}
+
+bool BVH::Refit(const std::vector<Object>& objects, const std::vector<std::shared_ptr<const Mesh>>& meshes,
+    const std::vector<std::pair<size_t, size_t>>& ranges) {
+    if (nodes.empty() || primitive_leaves.size() != objects.size()) {
+        return false;
+    }
+    // Leaves holding a changed object. Their objects are bounded again before any node changes, so a failed refit leaves
+    // the tree as it was
+    std::vector<int> queued;
+    for (const auto& range : ranges) {
+        // Ranges may be marked past the last object, like SceneBuffer::Update only the objects that exist are read
+        size_t end = std::min(range.second, objects.size());
+        for (size_t i = range.first; i < end; ++i) {
+            glm::vec3 bounds_min, bounds_max;
+            bool bounded = ObjectBounds(objects[i], meshes, bounds_min, bounds_max);
+            if (bounded != (primitive_leaves[i] >= 0)) {
+                for (int node_index : queued) {
+                    refit_marks[node_index] = 0;
+                }
+                return false;
+            }
+            if (bounded) {
+                primitive_bounds[i] = std::make_pair(bounds_min, bounds_max);
+                if (!refit_marks[primitive_leaves[i]]) {
+                    refit_marks[primitive_leaves[i]] = 1;
+                    queued.push_back(primitive_leaves[i]);
+                }
+            }
+        }
+    }
+    // Every node above them, each once: a walk stops at the first node an earlier one already queued
+    size_t leaf_count = queued.size();
+    for (size_t i = 0; i < leaf_count; ++i) {
+        for (int parent = parents[queued[i]]; parent >= 0 && !refit_marks[parent]; parent = parents[parent]) {
+            refit_marks[parent] = 1;
+            queued.push_back(parent);
+        }
+    }
+
+    // Children are stored after their parent, so going through the nodes backwards updates both children first.
+    // A leaf is bounded again from all of its objects, the moved one may have been the one on its boundary
+    std::sort(queued.begin(), queued.end(), std::greater<int>());
+    for (int node_index : queued) {
+        const BVHNode& node = nodes[node_index];
+        glm::vec3 bounds_min(INFINITY);
+        glm::vec3 bounds_max(-INFINITY);
+        if (node.count > 0) {
+            for (int i = node.right_or_first; i < node.right_or_first + node.count; ++i) {
+                bounds_min = glm::min(bounds_min, primitive_bounds[primitive_indices[i]].first);
+                bounds_max = glm::max(bounds_max, primitive_bounds[primitive_indices[i]].second);
+            }
+        }
+        else {
+            bounds_min = glm::min(nodes[node_index + 1].bounds_min, nodes[node.right_or_first].bounds_min);
+            bounds_max = glm::max(nodes[node_index + 1].bounds_max, nodes[node.right_or_first].bounds_max);
+        }
+        SetNodeBounds(node_index, bounds_min, bounds_max);
+        refit_marks[node_index] = 0;
+    }
+    return GetGrowth() <= BVH_REFIT_GROWTH_LIMIT;
+}
+
+// Nodes that had no area when built, like a leaf holding a sphere of radius 0, count as grown by their new area
+static double AreaGrowth(float area, float build_area) {
+    return build_area > 0.0f ? static_cast<double>(area) / build_area : 1.0 + area;
+}
+
+void BVH::SetNodeBounds(int node_index, const glm::vec3& bounds_min, const glm::vec3& bounds_max) {
+    BVHNode& node = nodes[node_index];
+    float build_area = build_areas[node_index];
+    double growth = AreaGrowth(SurfaceArea(bounds_min, bounds_max), build_area) - AreaGrowth(SurfaceArea(node.bounds_min, node.bounds_max), build_area);
+    weighted_growth += NodeCostWeight(node) * growth;
+    node.bounds_min = bounds_min;
+    node.bounds_max = bounds_max;
+}
+
+void BVH::BuildPrimitives() {
+    nodes.clear();
+    primitive_indices.clear();
+    if (build_primitives.empty()) {
+        return;
+    }
+    nodes.reserve(2 * build_primitives.size());
+    primitive_indices.reserve(build_primitives.size());
+    BuildNode(0, build_primitives.size(), 0);
+    // Only needed while building, a mesh can hold millions of them
+    build_primitives.clear();
+    build_primitives.shrink_to_fit();
+}
+
+int BVH::BuildNode(size_t begin, size_t end, int depth) {
+    int node_index = static_cast<int>(nodes.size());
+    nodes.push_back(BVHNode{ glm::vec3(INFINITY), 0, glm::vec3(-INFINITY), 0 });
+
+    glm::vec3 centroid_min(INFINITY);
+    glm::vec3 centroid_max(-INFINITY);
+    for (size_t i = begin; i < end; ++i) {
+        nodes[node_index].bounds_min = glm::min(nodes[node_index].bounds_min, build_primitives[i].bounds_min);
+        nodes[node_index].bounds_max = glm::max(nodes[node_index].bounds_max, build_primitives[i].bounds_max);
+        centroid_min = glm::min(centroid_min, build_primitives[i].centroid);
+        centroid_max = glm::max(centroid_max, build_primitives[i].centroid);
+    }
+
+    size_t count = end - begin;
+    if (count == 1 || depth >= BVH_MAX_DEPTH - 1) {
+        MakeLeaf(nodes[node_index], begin, end);
+        return node_index;
+    }
+
+    // Find the cheapest split over all axes using binned centroids
+    float parent_area = SurfaceArea(nodes[node_index].bounds_min, nodes[node_index].bounds_max);
+    float best_cost = INFINITY;
+    int best_axis = -1;
+    int best_split = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        float extent = centroid_max[axis] - centroid_min[axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+
+        struct Bin {
+            glm::vec3 bounds_min = glm::vec3(INFINITY);
+            glm::vec3 bounds_max = glm::vec3(-INFINITY);
+            int count = 0;
+        } bins[BVH_BIN_COUNT];
+        float scale = BVH_BIN_COUNT / extent;
+        for (size_t i = begin; i < end; ++i) {
+            int bin = std::min(BVH_BIN_COUNT - 1, static_cast<int>((build_primitives[i].centroid[axis] - centroid_min[axis]) * scale));
+            bins[bin].bounds_min = glm::min(bins[bin].bounds_min, build_primitives[i].bounds_min);
+            bins[bin].bounds_max = glm::max(bins[bin].bounds_max, build_primitives[i].bounds_max);
+            bins[bin].count++;
+        }
+
+        // Sweep from the right to get the area and count on the right of every split
+        float right_area[BVH_BIN_COUNT - 1];
+        int right_count[BVH_BIN_COUNT - 1];
+        glm::vec3 right_min(INFINITY);
+        glm::vec3 right_max(-INFINITY);
+        int right_total = 0;
+        for (int split = BVH_BIN_COUNT - 1; split > 0; --split) {
+            right_min = glm::min(right_min, bins[split].bounds_min);
+            right_max = glm::max(right_max, bins[split].bounds_max);
+            right_total += bins[split].count;
+            right_area[split - 1] = SurfaceArea(right_min, right_max);
+            right_count[split - 1] = right_total;
+        }
+
+        glm::vec3 left_min(INFINITY);
+        glm::vec3 left_max(-INFINITY);
+        int left_total = 0;
+        for (int split = 0; split < BVH_BIN_COUNT - 1; ++split) {
+            left_min = glm::min(left_min, bins[split].bounds_min);
+            left_max = glm::max(left_max, bins[split].bounds_max);
+            left_total += bins[split].count;
+            if (left_total == 0 || right_count[split] == 0) {
+                continue;
+            }
+            float cost = TRAVERSAL_COST + INTERSECTION_COST * (SurfaceArea(left_min, left_max) * left_total + right_area[split] * right_count[split]) / parent_area;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = split;
+            }
+        }
+    }
+
+    size_t middle;
+    if (best_axis == -1) {
+        // All centroids coincide, no split can separate them
+        if (count <= BVH_MAX_LEAF_SIZE) {
+            MakeLeaf(nodes[node_index], begin, end);
+            return node_index;
+        }
+        middle = begin + count / 2;
+    }
+    else {
+        float leaf_cost = INTERSECTION_COST * count;
+        if (leaf_cost <= best_cost && count <= BVH_MAX_LEAF_SIZE) {
+            MakeLeaf(nodes[node_index], begin, end);
+            return node_index;
+        }
+
+        float scale = BVH_BIN_COUNT / (centroid_max[best_axis] - centroid_min[best_axis]);
+        float axis_min = centroid_min[best_axis];
+        auto split_point = std::partition(build_primitives.begin() + begin, build_primitives.begin() + end, [&](const BuildPrimitive& primitive) {
+            int bin = std::min(BVH_BIN_COUNT - 1, static_cast<int>((primitive.centroid[best_axis] - axis_min) * scale));
+            return bin <= best_split;
+        });
+        middle = split_point - build_primitives.begin();
+    }
+
+    // The left child is always the next node, so only the right one has to be stored
+    BuildNode(begin, middle, depth + 1);
+    int right = BuildNode(middle, end, depth + 1);
+    nodes[node_index].right_or_first = right;
+    return node_index;
+}
+
+void BVH::MakeLeaf(BVHNode& node, size_t begin, size_t end) {
+    node.right_or_first = static_cast<int>(primitive_indices.size());
+    node.count = static_cast<int>(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        primitive_indices.push_back(build_primitives[i].index);
+    }
+}
+
+//Getters
+const std::vector<BVHNode>& BVH::GetNodes() const {
+    return nodes;
+}
+
+const std::vector<int>& BVH::GetPrimitiveIndices() const {
+    return primitive_indices;
+}
+
+float BVH::GetCost() const {
+    if (nodes.empty()) {
+        return 0.0f;
+    }
+    double cost = 0.0;
+    for (const BVHNode& node : nodes) {
+        cost += NodeCostWeight(node) * SurfaceArea(node.bounds_min, node.bounds_max);
+    }
+    float root_area = SurfaceArea(nodes[0].bounds_min, nodes[0].bounds_max);
+    return root_area > 0.0f ? static_cast<float>(cost / root_area) : 0.0f;
+}
+
+float BVH::GetGrowth() const {
+    return total_weight > 0.0 ? static_cast<float>(weighted_growth / total_weight) : 1.0f;
+}
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "../include/BlueNoise.h"
+
+namespace {
+
+// Width of the Gaussian that measures how crowded a pixel is
+const float BLUE_NOISE_SIGMA = 1.5f;
+// Fraction of the pixels set in the initial pattern
+const int BLUE_NOISE_INITIAL_DIVISOR = 10;
+
+struct Pattern {
+    std::vector<char> set;
+    std::vector<float> energy; // Gaussian weighted count of the set pixels around each pixel, on a torus
+};
+
+void Toggle(Pattern& pattern, const std::vector<float>& kernel, int pixel) {
+    float sign = pattern.set[pixel] ? -1.0f : 1.0f;
+    pattern.set[pixel] = !pattern.set[pixel];
+    int px = pixel % BLUE_NOISE_SIZE;
+    int py = pixel / BLUE_NOISE_SIZE;
+    for (int y = 0; y < BLUE_NOISE_SIZE; ++y) {
+        const float* row = kernel.data() + ((y - py + BLUE_NOISE_SIZE) % BLUE_NOISE_SIZE) * BLUE_NOISE_SIZE;
+        for (int x = 0; x < BLUE_NOISE_SIZE; ++x) {
+            pattern.energy[y * BLUE_NOISE_SIZE + x] += sign * row[(x - px + BLUE_NOISE_SIZE) % BLUE_NOISE_SIZE];
+        }
+    }
+}
+
+// The set pixel with the most set neighbours
+int TightestCluster(const Pattern& pattern) {
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(pattern.set.size()); ++i) {
+        if (pattern.set[i] && (best < 0 || pattern.energy[i] > pattern.energy[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// The empty pixel farthest from the set ones
+int LargestVoid(const Pattern& pattern) {
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(pattern.set.size()); ++i) {
+        if (!pattern.set[i] && (best < 0 || pattern.energy[i] < pattern.energy[best])) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+}
+
+std::vector<uint16_t> GenerateBlueNoise(unsigned int seed) {
+    const int pixel_count = BLUE_NOISE_SIZE * BLUE_NOISE_SIZE;
+    std::vector<float> kernel(pixel_count);
+    for (int y = 0; y < BLUE_NOISE_SIZE; ++y) {
+        for (int x = 0; x < BLUE_NOISE_SIZE; ++x) {
+            float dx = static_cast<float>(std::min(x, BLUE_NOISE_SIZE - x));
+            float dy = static_cast<float>(std::min(y, BLUE_NOISE_SIZE - y));
+            kernel[y * BLUE_NOISE_SIZE + x] = std::exp(-(dx * dx + dy * dy) / (2 * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+        }
+    }
+
+    // Random initial pattern, then move its tightest cluster into its largest void until that changes nothing
+    Pattern initial = { std::vector<char>(pixel_count, 0), std::vector<float>(pixel_count, 0.0f) };
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> distribution(0, pixel_count - 1);
+    int initial_count = pixel_count / BLUE_NOISE_INITIAL_DIVISOR;
+    for (int placed = 0; placed < initial_count;) {
+        int pixel = distribution(gen);
+        if (!initial.set[pixel]) {
+            Toggle(initial, kernel, pixel);
+            ++placed;
+        }
+    }
+    for (int iteration = 0; iteration < pixel_count; ++iteration) {
+        int cluster = TightestCluster(initial);
+        Toggle(initial, kernel, cluster);
+        int largest_void = LargestVoid(initial);
+        Toggle(initial, kernel, largest_void);
+        if (largest_void == cluster) {
+            break;
+        }
+    }
+
+    // Ranks below the initial pattern take away its tightest clusters, ranks above it fill the largest voids
+    std::vector<uint16_t> ranks(pixel_count);
+    Pattern pattern = initial;
+    for (int rank = initial_count - 1; rank >= 0; --rank) {
+        int cluster = TightestCluster(pattern);
+        Toggle(pattern, kernel, cluster);
+        ranks[cluster] = static_cast<uint16_t>(rank);
+    }
+    pattern = initial;
+    for (int rank = initial_count; rank < pixel_count; ++rank) {
+        int largest_void = LargestVoid(pattern);
+        Toggle(pattern, kernel, largest_void);
+        ranks[largest_void] = static_cast<uint16_t>(rank);
+    }
+    return ranks;
+}
@@ -0,0 +1,926 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <variant>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../include/CPURenderer.h"
+#include "../include/BlueNoise.h"
+#include "../include/Camera.h"
+#include "../include/Random.h"
+
+// The functions below mirror raytracing_common.glsl, and getRayColor and getRay of raytracing.fs.glsl, one to one and
+// keep their names, change both together
+
+namespace {
+
+const float PI = 3.1415926f;
+
+struct Interval {
+    float min;
+    float max;
+};
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+// The u_ uniforms of the shaders that stay the same for a whole render
+struct Uniforms {
+    int light_bounces;
+    int roulette_depth;
+    glm::vec3 sky_horizon;
+    glm::vec3 sky_zenith;
+    const int* lights;
+    int light_count;
+};
+
+struct HitRecord {
+    glm::vec3 p;
+    glm::vec3 normal;
+    float t;
+    bool front_face;
+    Material material;
+    int object; // BVH slot in the CPUScene, not the index in Scene::objects
+};
+
+float lengthSquared(const glm::vec3& v) {
+    return glm::dot(v, v);
+}
+int quadAxis(const glm::vec3& half_size) {
+    return half_size.x == 0.0f ? 0 : (half_size.y == 0.0f ? 1 : 2);
+}
+
+bool surrounds(const Interval& i, float x) {
+    return i.min < x && x < i.max;
+}
+
+//random number generation
+float rand(uint32_t& state) {
+    return RandomFloat(state);
+}
+
+//sampling
+struct Sampler {
+    glm::uvec2 pixel;
+    uint32_t index;
+    uint32_t frame;
+    uint32_t dimension;
+    uint32_t rng;
+    // u_sampler and u_blueNoise
+    SamplerType type;
+    const uint16_t* blue_noise;
+};
+
+Sampler initSampler(glm::uvec2 pixel, uint32_t sample_index, uint32_t frame, SamplerType type, const uint16_t* blue_noise) {
+    return Sampler{ pixel, sample_index, frame, 0, InitRandom(pixel.x, pixel.y, sample_index, frame), type, blue_noise };
+}
+glm::vec2 sobol2D(const Sampler& s) {
+    uint32_t seed = PCGHash(s.dimension + PCGHash(s.pixel.x + PCGHash(s.pixel.y + PCGHash(s.frame))));
+    uint32_t index = NestedUniformScramble(s.index, seed);
+    uint32_t x = NestedUniformScramble(ReverseBits(index), PCGHash(seed + 1u));
+    uint32_t y = NestedUniformScramble(Sobol1(index), PCGHash(seed + 2u));
+    return glm::vec2(ToUnitFloat(x), ToUnitFloat(y));
+}
+glm::vec2 blueNoise2D(const Sampler& s) {
+    uint32_t offset = PCGHash(s.dimension + PCGHash(s.frame));
+    glm::uvec2 pixel_x = (s.pixel + glm::uvec2(offset, offset >> 8)) % glm::uvec2(BLUE_NOISE_SIZE);
+    glm::uvec2 pixel_y = (s.pixel + glm::uvec2(offset >> 16, offset >> 24)) % glm::uvec2(BLUE_NOISE_SIZE);
+    uint32_t x = (static_cast<uint32_t>(s.blue_noise[pixel_x.y * BLUE_NOISE_SIZE + pixel_x.x]) << 20) + s.index * 3242174889u;
+    uint32_t y = (static_cast<uint32_t>(s.blue_noise[pixel_y.y * BLUE_NOISE_SIZE + pixel_y.x]) << 20) + s.index * 2447445414u;
+    return glm::vec2(ToUnitFloat(x), ToUnitFloat(y));
+}
+glm::vec2 sample2D(Sampler& s) {
+    glm::vec2 u;
+    if (s.type == SamplerType::Sobol) {
+        u = sobol2D(s);
+    }
+    else if (s.type == SamplerType::BlueNoise) {
+        u = blueNoise2D(s);
+    }
+    else {
+        u.x = rand(s.rng);
+        u.y = rand(s.rng);
+    }
+    s.dimension += 2;
+    return u;
+}
+
+glm::vec3 randomUnitVector(Sampler& s) {
+    glm::vec2 u = sample2D(s);
+    float z = 1.0f - 2.0f * u.x;
+    float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+    float phi = 2.0f * PI * u.y;
+    return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+glm::vec3 cosineSampleHemisphere(const glm::vec2& u) {
+    float r = std::sqrt(u.x);
+    float phi = 2.0f * PI * u.y;
+    return glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(0.0f, 1.0f - u.x)));
+}
+glm::mat3 orthonormalBasis(const glm::vec3& n) {
+    float flip = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (flip + n.z);
+    float b = n.x * n.y * a;
+    glm::vec3 tangent(1.0f + flip * n.x * n.x * a, flip * b, -flip * n.x);
+    glm::vec3 bitangent(b, flip + n.y * n.y * a, -n.y);
+    return glm::mat3(tangent, bitangent, n);
+}
+
+glm::vec3 skyColor(const glm::vec3& direction, const glm::vec3& sky_horizon, const glm::vec3& sky_zenith) {
+    glm::vec3 unit_direction = glm::normalize(direction);
+    float a = 0.5f * (unit_direction.y + 1.0f);
+    return (1.0f - a) * sky_horizon + a * sky_zenith;
+}
+
+bool survivesRoulette(int depth, glm::vec3& throughput, Sampler& sampler, int roulette_depth) {
+    if (roulette_depth < 0 || depth < roulette_depth) {
+        return true;
+    }
+    float survival = std::min(std::max(throughput.r, std::max(throughput.g, throughput.b)), 1.0f);
+    if (sample2D(sampler).x >= survival) {
+        return false;
+    }
+    throughput /= survival;
+    return true;
+}
+
+//material functions
+glm::vec3 reflect(const glm::vec3& v, const glm::vec3& n) {
+    return v - 2 * glm::dot(v, n) * n;
+}
+glm::vec3 refract(const glm::vec3& r_in, const glm::vec3& normal, float etaI_over_etaT) {
+    float cos_theta = std::min(1.0f, glm::dot(-r_in, normal));
+    glm::vec3 r_out_perp = etaI_over_etaT * (r_in + cos_theta * normal);
+    glm::vec3 r_out_parallel = -std::sqrt(std::abs(1.0f - glm::dot(r_out_perp, r_out_perp))) * normal;
+    return r_out_perp + r_out_parallel;
+}
+float reflectance(float cosine, float ref_idx) {
+    float r0 = (1 - ref_idx) / (1 + ref_idx);
+    r0 = r0 * r0;
+    return r0 + (1 - r0) * std::pow((1 - cosine), 5.0f);
+}
+// Scattering by material, one overload per type of MaterialVariant. These are the cases of scatter in the shader
+bool scatterMaterial(const Lambertian& material, const Ray&, const HitRecord& rec, glm::vec3& attenuation, Ray& scattered, Sampler& sampler) {
+    glm::vec3 scatter_direction = orthonormalBasis(rec.normal) * cosineSampleHemisphere(sample2D(sampler));
+    scattered.origin = rec.p;
+    scattered.direction = scatter_direction;
+    attenuation = material.albedo;
+    return true;
+}
+bool scatterMaterial(const Metal& material, const Ray& r_in, const HitRecord& rec, glm::vec3& attenuation, Ray& scattered, Sampler& sampler) {
+    glm::vec3 reflected = reflect(glm::normalize(r_in.direction), rec.normal);
+    scattered.origin = rec.p;
+    scattered.direction = reflected + material.fuzz * randomUnitVector(sampler);
+    attenuation = material.albedo;
+    return glm::dot(scattered.direction, rec.normal) > 0;
+}
+bool scatterMaterial(const Dielectric& material, const Ray& r_in, const HitRecord& rec, glm::vec3& attenuation, Ray& scattered, Sampler&) {
+    attenuation = glm::vec3(1.0f);
+    float refraction_ratio = rec.front_face ? (1.0f / material.refraction_index) : material.refraction_index;
+    glm::vec3 unit_direction = glm::normalize(r_in.direction);
+
+    float cos_theta = std::min(1.0f, glm::dot(-unit_direction, rec.normal));
+    float sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+    bool cannot_refract = refraction_ratio * sin_theta > 1.0f;
+
+    // The shader uses a fixed threshold instead of a random one
+    float random_val = 0.5f;
+    glm::vec3 direction;
+    if (cannot_refract || reflectance(cos_theta, refraction_ratio) > random_val) {
+        direction = reflect(unit_direction, rec.normal);
+    }
+    else {
+        direction = refract(unit_direction, rec.normal, refraction_ratio);
+    }
+    scattered.origin = rec.p;
+    scattered.direction = direction;
+    return true;
+}
+bool scatterMaterial(const Absorbing&, const Ray& r_in, const HitRecord&, glm::vec3& attenuation, Ray& scattered, Sampler&) {
+    // Undefined in the shader, treated as absorbing here
+    attenuation = glm::vec3(0.0f);
+    scattered = r_in;
+    return true;
+}
+// Picks the overload by a switch on the material type of the hit, like the shader does. The baseline of
+// --benchmark materials
+bool scatter(const Ray& r_in, const HitRecord& rec, glm::vec3& attenuation, Ray& scattered, Sampler& sampler) {
+    switch (rec.material.type) {
+    case MaterialType::Lambertian:
+        return scatterMaterial(Lambertian{ rec.material.albedo }, r_in, rec, attenuation, scattered, sampler);
+    case MaterialType::Metal:
+        return scatterMaterial(Metal{ rec.material.albedo, rec.material.fuzz }, r_in, rec, attenuation, scattered, sampler);
+    case MaterialType::Dielectric:
+        return scatterMaterial(Dielectric{ rec.material.refraction_index }, r_in, rec, attenuation, scattered, sampler);
+    default:
+        return scatterMaterial(Absorbing{}, r_in, rec, attenuation, scattered, sampler);
+    }
+}
+// Picks the overload by std::visit on the material of the CPUScene, which the compiler turns into a jump table
+bool scatter(const MaterialVariant& material, const Ray& r_in, const HitRecord& rec, glm::vec3& attenuation, Ray& scattered, Sampler& sampler) {
+    return std::visit([&](const auto& typed) { return scatterMaterial(typed, r_in, rec, attenuation, scattered, sampler); }, material);
+}
+
+// Ray Functions
+glm::vec3 rotate(const glm::quat& q, const glm::vec3& v) {
+    glm::vec3 q_xyz(q.x, q.y, q.z);
+    glm::vec3 t = 2.0f * glm::cross(q_xyz, v);
+    return v + q.w * t + glm::cross(q_xyz, t);
+}
+glm::vec3 at(const Ray& r, float t) {
+    return r.origin + t * r.direction;
+}
+bool hitSphere(const glm::vec3& center, float radius, const Ray& r, const Interval& ray_t, HitRecord& rec) {
+    glm::vec3 oc = r.origin - center;
+    float a = glm::dot(r.direction, r.direction);
+    float half_b = glm::dot(oc, r.direction);
+    float c = glm::dot(oc, oc) - radius * radius;
+    float discriminant = half_b * half_b - a * c;
+    if (discriminant < 0) {
+        return false;
+    }
+    float root = (-half_b - std::sqrt(discriminant)) / a;
+    if (!surrounds(ray_t, root)) {
+        root = (-half_b + std::sqrt(discriminant)) / a;
+        if (!surrounds(ray_t, root)) {
+            return false;
+        }
+    }
+    rec.t = root;
+    rec.p = at(r, rec.t);
+    glm::vec3 outward_normal = (rec.p - center) / radius;
+    rec.front_face = glm::dot(r.direction, outward_normal) < 0;
+    rec.normal = rec.front_face ? outward_normal : -outward_normal;
+    return true;
+}
+bool hitQuad(const glm::vec3& center, const glm::vec3& half_size, const Ray& r, const Interval& ray_t, HitRecord& rec) {
+    int axis = quadAxis(half_size);
+    if (r.direction[axis] == 0.0f) {
+        return false;
+    }
+    float t = (center[axis] - r.origin[axis]) / r.direction[axis];
+    if (!surrounds(ray_t, t)) {
+        return false;
+    }
+    glm::vec3 p = at(r, t);
+    glm::vec3 from_center = glm::abs(p - center);
+    from_center[axis] = 0.0f;
+    if (glm::any(glm::greaterThan(from_center, glm::abs(half_size)))) {
+        return false;
+    }
+    rec.t = t;
+    rec.p = p;
+    glm::vec3 outward_normal(0.0f);
+    outward_normal[axis] = 1.0f;
+    rec.front_face = glm::dot(r.direction, outward_normal) < 0;
+    rec.normal = rec.front_face ? outward_normal : -outward_normal;
+    return true;
+}
+float hitAABB(const glm::vec3& bounds_min, const glm::vec3& bounds_max, const Ray& r, const glm::vec3& inv_direction, float t_min, float t_max) {
+    glm::vec3 t0 = (bounds_min - r.origin) * inv_direction;
+    glm::vec3 t1 = (bounds_max - r.origin) * inv_direction;
+    glm::vec3 t_near = glm::min(t0, t1);
+    glm::vec3 t_far = glm::max(t0, t1);
+    float t_enter = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, t_min));
+    float t_exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, t_max));
+    return t_enter <= t_exit ? t_enter : INFINITY;
+}
+//meshes
+struct TriangleRay {
+    glm::ivec3 axes;
+    glm::vec3 shear;
+};
+TriangleRay initTriangleRay(const glm::vec3& direction) {
+    glm::vec3 a = glm::abs(direction);
+    int kz = a.x > a.y ? (a.x > a.z ? 0 : 2) : (a.y > a.z ? 1 : 2);
+    int kx = kz == 2 ? 0 : kz + 1;
+    int ky = kx == 2 ? 0 : kx + 1;
+    return TriangleRay{ glm::ivec3(kx, ky, kz), glm::vec3(-direction[kx] / direction[kz], -direction[ky] / direction[kz], 1.0f / direction[kz]) };
+}
+glm::vec3 shearVertex(const glm::vec3& p, const TriangleRay& triangle_ray) {
+    glm::vec3 q(p[triangle_ray.axes.x], p[triangle_ray.axes.y], p[triangle_ray.axes.z]);
+    return glm::vec3(q.x + triangle_ray.shear.x * q.z, q.y + triangle_ray.shear.y * q.z, q.z * triangle_ray.shear.z);
+}
+float hitTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& origin, const TriangleRay& triangle_ray, const Interval& ray_t, glm::vec3& barycentric) {
+    glm::vec3 a = shearVertex(p0 - origin, triangle_ray);
+    glm::vec3 b = shearVertex(p1 - origin, triangle_ray);
+    glm::vec3 c = shearVertex(p2 - origin, triangle_ray);
+    float e0 = b.x * c.y - b.y * c.x;
+    float e1 = c.x * a.y - c.y * a.x;
+    float e2 = a.x * b.y - a.y * b.x;
+    if ((e0 < 0.0f || e1 < 0.0f || e2 < 0.0f) && (e0 > 0.0f || e1 > 0.0f || e2 > 0.0f)) {
+        return INFINITY;
+    }
+    float det = e0 + e1 + e2;
+    if (det == 0.0f) {
+        return INFINITY;
+    }
+    float t = (e0 * a.z + e1 * b.z + e2 * c.z) / det;
+    if (!surrounds(ray_t, t)) {
+        return INFINITY;
+    }
+    barycentric = glm::vec3(e0, e1, e2) / det;
+    return t;
+}
+bool hitMesh(const ObjectShape& object, const glm::quat& rotation, const Mesh& mesh, const Ray& r, const Interval& ray_t, HitRecord& rec) {
+    const std::vector<BVHNode>& nodes = mesh.bvh.GetNodes();
+    glm::quat inverse_rotation(rotation.w, -rotation.x, -rotation.y, -rotation.z);
+    Ray local = { rotate(inverse_rotation, r.origin - object.position) / object.scale, rotate(inverse_rotation, r.direction) / object.scale };
+    glm::vec3 inv_direction = 1.0f / local.direction;
+    TriangleRay triangle_ray = initTriangleRay(local.direction);
+    int hit_triangle = -1;
+    glm::vec3 hit_barycentric(0.0f);
+    float closest_so_far = ray_t.max;
+
+    int stack[BVH_MAX_DEPTH];
+    int stack_size = 0;
+    int node_index = 0;
+    if (hitAABB(nodes[0].bounds_min, nodes[0].bounds_max, local, inv_direction, ray_t.min, closest_so_far) == INFINITY) {
+        return false;
+    }
+    while (true) {
+        const BVHNode& node = nodes[node_index];
+        if (node.count > 0) {
+            for (int i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+                const glm::uvec3& triangle = mesh.triangles[i];
+                glm::vec3 barycentric;
+                float t = hitTriangle(mesh.positions[triangle.x], mesh.positions[triangle.y], mesh.positions[triangle.z], local.origin, triangle_ray,
+                    Interval{ ray_t.min, closest_so_far }, barycentric);
+                if (t != INFINITY) {
+                    closest_so_far = t;
+                    hit_triangle = i;
+                    hit_barycentric = barycentric;
+                }
+            }
+        }
+        else {
+            int near_child = node_index + 1;
+            int far_child = node.right_or_first;
+            float t_near = hitAABB(nodes[near_child].bounds_min, nodes[near_child].bounds_max, local, inv_direction, ray_t.min, closest_so_far);
+            float t_far = hitAABB(nodes[far_child].bounds_min, nodes[far_child].bounds_max, local, inv_direction, ray_t.min, closest_so_far);
+            if (t_far < t_near) {
+                std::swap(near_child, far_child);
+                std::swap(t_near, t_far);
+            }
+            if (t_near != INFINITY) {
+                if (t_far != INFINITY && stack_size < BVH_MAX_DEPTH) {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    if (hit_triangle < 0) {
+        return false;
+    }
+
+    const glm::uvec3& triangle = mesh.triangles[hit_triangle];
+    const glm::vec3& p0 = mesh.positions[triangle.x];
+    const glm::vec3& p1 = mesh.positions[triangle.y];
+    const glm::vec3& p2 = mesh.positions[triangle.z];
+    glm::vec3 normal = hit_barycentric.x * mesh.normals[triangle.x] + hit_barycentric.y * mesh.normals[triangle.y] + hit_barycentric.z * mesh.normals[triangle.z];
+    glm::vec3 geometric_normal = glm::normalize(rotate(rotation, glm::cross(p1 - p0, p2 - p0) / object.scale));
+    normal = lengthSquared(normal) > 0.0f ? glm::normalize(rotate(rotation, normal / object.scale)) : geometric_normal;
+    if (glm::dot(geometric_normal, normal) < 0.0f) {
+        geometric_normal = -geometric_normal;
+    }
+    rec.t = closest_so_far;
+    rec.p = at(r, rec.t);
+    rec.front_face = glm::dot(r.direction, geometric_normal) < 0;
+    rec.normal = rec.front_face ? normal : -normal;
+    return true;
+}
+// Unlike the shader, the hit tests leave the material to hit, which only looks up the one of the nearest object
+bool hitObject(const CPUScene& scene, int slot, const Ray& r, const Interval& ray_t, HitRecord& rec) {
+    const ObjectShape& object = scene.shapes[slot];
+    switch (object.type) {
+    case ObjectType::Sphere:
+        return hitSphere(object.position, object.radius, r, ray_t, rec);
+    case ObjectType::Quad:
+        return hitQuad(object.position, object.scale, r, ray_t, rec);
+    case ObjectType::Mesh:
+        return hitMesh(object, scene.rotations[slot], *scene.slot_meshes[slot], r, ray_t, rec);
+    default:
+        return false;
+    }
+}
+bool hit(const CPUScene& scene, const Ray& r, const Interval& ray_t, HitRecord& rec) {
+    const std::vector<BVHNode>& nodes = scene.bvh.GetNodes();
+    if (scene.shapes.empty()) {
+        return false;
+    }
+    HitRecord temp_rec;
+    bool hit_anything = false;
+    float closest_so_far = ray_t.max;
+    glm::vec3 inv_direction = 1.0f / r.direction;
+
+    int stack[BVH_MAX_DEPTH];
+    int stack_size = 0;
+    int node_index = 0;
+    if (hitAABB(nodes[0].bounds_min, nodes[0].bounds_max, r, inv_direction, ray_t.min, closest_so_far) == INFINITY) {
+        return false;
+    }
+    while (true) {
+        const BVHNode& node = nodes[node_index];
+        const glm::ivec2& batch = scene.spheres.batches[node_index];
+        if (batch.y > 0) {
+            // A few spheres under this node are tested at once instead of box by box, which the shader does not do. Only
+            // the nearest is hit again to fill in its record. Spheres at exactly the same distance may resolve differently
+            float sphere_t[SPHERE_BATCH_SIZE];
+            HitSpheres(scene.spheres, batch.x, batch.y, r.origin, r.direction, ray_t.min, closest_so_far, sphere_t);
+            int nearest = -1;
+            float nearest_t = closest_so_far;
+            for (int i = 0; i < batch.y; i++) {
+                if (sphere_t[i] < nearest_t) {
+                    nearest_t = sphere_t[i];
+                    nearest = batch.x + i;
+                }
+            }
+            if (nearest >= 0 && hitObject(scene, nearest, r, Interval{ ray_t.min, closest_so_far }, temp_rec)) {
+                temp_rec.object = nearest;
+                hit_anything = true;
+                closest_so_far = temp_rec.t;
+                rec = temp_rec;
+            }
+        }
+        else if (node.count > 0) {
+            for (int i = node.right_or_first; i < node.right_or_first + node.count; i++) {
+                if (hitObject(scene, i, r, Interval{ ray_t.min, closest_so_far }, temp_rec)) {
+                    temp_rec.object = i;
+                    hit_anything = true;
+                    closest_so_far = temp_rec.t;
+                    rec = temp_rec;
+                }
+            }
+        }
+        else {
+            int near_child = node_index + 1;
+            int far_child = node.right_or_first;
+            float t_near = hitAABB(nodes[near_child].bounds_min, nodes[near_child].bounds_max, r, inv_direction, ray_t.min, closest_so_far);
+            float t_far = hitAABB(nodes[far_child].bounds_min, nodes[far_child].bounds_max, r, inv_direction, ray_t.min, closest_so_far);
+            if (t_far < t_near) {
+                std::swap(near_child, far_child);
+                std::swap(t_near, t_far);
+            }
+            if (t_near != INFINITY) {
+                if (t_far != INFINITY && stack_size < BVH_MAX_DEPTH) {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    if (hit_anything) {
+        rec.material = scene.material_table[scene.materials[rec.object]];
+    }
+    return hit_anything;
+}
+//lights
+bool isSampledLight(int object, const Uniforms& uniforms) {
+    for (int i = 0; i < uniforms.light_count; i++) {
+        if (uniforms.lights[i] == object) {
+            return true;
+        }
+    }
+    return false;
+}
+glm::vec3 emitted(const CPUScene& scene, const HitRecord& rec) {
+    if (rec.material.type != MaterialType::Emissive || (!rec.front_face && scene.shapes[rec.object].type != ObjectType::Quad)) {
+        return glm::vec3(0.0f);
+    }
+    return rec.material.albedo;
+}
+float coneSolidAngleFactor(float x) {
+    return x / (1.0f + std::sqrt(1.0f - x));
+}
+float lightPdf(const ObjectShape& light, const glm::vec3& p, const glm::vec3& light_point) {
+    if (light.type == ObjectType::Sphere) {
+        float radius_squared = light.radius * light.radius;
+        float distance_squared = lengthSquared(light.position - p);
+        if (distance_squared <= radius_squared) {
+            return 0.0f;
+        }
+        return 1.0f / (2.0f * PI * coneSolidAngleFactor(radius_squared / distance_squared));
+    }
+    if (light.type == ObjectType::Quad) {
+        int axis = quadAxis(light.scale);
+        glm::vec3 to_light = light_point - p;
+        float distance_squared = lengthSquared(to_light);
+        float cosine = std::abs(to_light[axis]) / std::sqrt(distance_squared);
+        glm::vec3 extent = glm::abs(light.scale);
+        extent[axis] = 1.0f;
+        float area = 4.0f * extent.x * extent.y * extent.z;
+        return cosine > 0.0f ? distance_squared / (area * cosine) : 0.0f;
+    }
+    return 0.0f;
+}
+bool sampleLight(const ObjectShape& light, const glm::vec3& p, const glm::vec2& u, glm::vec3& direction, float& pdf) {
+    if (light.type == ObjectType::Sphere) {
+        glm::vec3 to_center = light.position - p;
+        float distance_squared = lengthSquared(to_center);
+        float radius_squared = light.radius * light.radius;
+        if (distance_squared <= radius_squared) {
+            return false;
+        }
+        float one_minus_cos_max = coneSolidAngleFactor(radius_squared / distance_squared);
+        float cos_theta = 1.0f - u.x * one_minus_cos_max;
+        float sin_theta = std::sqrt(std::max(0.0f, 1.0f - cos_theta * cos_theta));
+        float phi = 2.0f * PI * u.y;
+        direction = orthonormalBasis(to_center / std::sqrt(distance_squared)) * glm::vec3(std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, cos_theta);
+        pdf = 1.0f / (2.0f * PI * one_minus_cos_max);
+        return true;
+    }
+    if (light.type == ObjectType::Quad) {
+        int axis = quadAxis(light.scale);
+        glm::vec2 v = 2.0f * u - 1.0f;
+        glm::vec3 offset = axis == 0 ? glm::vec3(0.0f, v.x, v.y) : (axis == 1 ? glm::vec3(v.x, 0.0f, v.y) : glm::vec3(v.x, v.y, 0.0f));
+        glm::vec3 light_point = light.position + offset * light.scale;
+        pdf = lightPdf(light, p, light_point);
+        direction = glm::normalize(light_point - p);
+        return pdf > 0.0f;
+    }
+    return false;
+}
+float powerHeuristic(float pdf, float other_pdf) {
+    return (pdf * pdf) / (pdf * pdf + other_pdf * other_pdf);
+}
+glm::vec3 sampleDirectLight(const CPUScene& scene, const HitRecord& rec, const Uniforms& uniforms, Sampler& sampler) {
+    if (uniforms.light_count == 0) {
+        return glm::vec3(0.0f);
+    }
+    glm::vec2 u = sample2D(sampler);
+    float scaled = u.x * uniforms.light_count;
+    int slot = std::min(static_cast<int>(scaled), uniforms.light_count - 1);
+    u.x = scaled - slot;
+    int light = uniforms.lights[slot];
+
+    glm::vec3 direction;
+    float light_pdf;
+    if (!sampleLight(scene.shapes[light], rec.p, u, direction, light_pdf)) {
+        return glm::vec3(0.0f);
+    }
+    float cosine = glm::dot(direction, rec.normal);
+    if (cosine <= 0.0f) {
+        return glm::vec3(0.0f);
+    }
+    HitRecord shadow = {};
+    if (!hit(scene, Ray{ rec.p, direction }, Interval{ 0.001f, INFINITY }, shadow) || shadow.object != light) {
+        return glm::vec3(0.0f);
+    }
+    light_pdf /= uniforms.light_count;
+    float bsdf_pdf = cosine / PI;
+    return emitted(scene, shadow) * rec.material.albedo * (cosine / PI) * powerHeuristic(light_pdf, bsdf_pdf) / light_pdf;
+}
+float scatterPdf(const HitRecord& rec, const Ray& scattered) {
+    if (rec.material.type != MaterialType::Lambertian) {
+        return 0.0f;
+    }
+    return std::max(glm::dot(glm::normalize(scattered.direction), rec.normal), 0.0f) / PI;
+}
+float emissionWeight(const CPUScene& scene, const HitRecord& rec, const glm::vec3& origin, float bsdf_pdf, const Uniforms& uniforms) {
+    if (bsdf_pdf == 0.0f || !isSampledLight(rec.object, uniforms)) {
+        return 1.0f;
+    }
+    return powerHeuristic(bsdf_pdf, lightPdf(scene.shapes[rec.object], origin, rec.p) / uniforms.light_count);
+}
+
+// The locals of getRayColor between two bounces, so a wave of paths can be traced a bounce at a time
+struct PathState {
+    Ray ray;
+    glm::vec3 color;
+    glm::vec3 radiance;
+    float bsdf_pdf;
+    Sampler sampler;
+    HitRecord rec;
+    bool hit;
+};
+
+// One bounce of getRayColor after its hit test. Returns false once the path has ended, its radiance is then the result
+bool shadePath(const CPUScene& scene, PathState& path, int bounce, const Uniforms& uniforms) {
+    const HitRecord& rec = path.rec;
+    if (!path.hit) {
+        path.radiance += path.color * skyColor(path.ray.direction, uniforms.sky_horizon, uniforms.sky_zenith);
+        return false;
+    }
+    if (rec.material.type == MaterialType::Emissive) {
+        path.radiance += path.color * emitted(scene, rec) * emissionWeight(scene, rec, path.ray.origin, path.bsdf_pdf, uniforms);
+        return false;
+    }
+    if (rec.material.type == MaterialType::Lambertian) {
+        path.radiance += path.color * sampleDirectLight(scene, rec, uniforms, path.sampler);
+    }
+    Ray scattered;
+    glm::vec3 attenuation;
+    if (!scatter(scene.material_variants[scene.materials[rec.object]], path.ray, rec, attenuation, scattered, path.sampler)) {
+        path.radiance += path.color;
+        return false;
+    }
+    path.color *= attenuation;
+    path.bsdf_pdf = scatterPdf(rec, scattered);
+    path.ray = scattered;
+    return survivesRoulette(bounce + 1, path.color, path.sampler, uniforms.roulette_depth);
+}
+
+glm::vec3 getRayColor(const CPUScene& scene, Ray r, const Uniforms& uniforms, Sampler& sampler) {
+    PathState path = { r, glm::vec3(1.0f), glm::vec3(0.0f), 0.0f, sampler, HitRecord{}, false };
+    for (int i = 0; i < uniforms.light_bounces; i++) {
+        path.rec = {};
+        path.hit = hit(scene, path.ray, Interval{ 0.001f, INFINITY }, path.rec);
+        if (!shadePath(scene, path, i, uniforms)) {
+            return path.radiance;
+        }
+    }
+    return path.radiance + path.color;
+}
+
+//ray sorting, which the fragment shader does not have
+const int OCTANT_COUNT = 8;
+// One bin per material type and one for misses
+const int MATERIAL_BIN_COUNT = static_cast<int>(MaterialType::Emissive) + 2;
+
+int directionOctant(const glm::vec3& direction) {
+    return (direction.x < 0.0f ? 1 : 0) + (direction.y < 0.0f ? 2 : 0) + (direction.z < 0.0f ? 4 : 0);
+}
+
+// Stable counting sort of the paths in order by their bin. Counts the paths that are in the same bin as the one before
+// them, in the order they came in and in the sorted one
+template <typename BinFunction>
+void sortPaths(std::vector<int>& order, std::vector<int>& scratch, int bin_count, BinFunction bin, long long& coherent_before, long long& coherent_after) {
+    int starts[MATERIAL_BIN_COUNT > OCTANT_COUNT ? MATERIAL_BIN_COUNT + 1 : OCTANT_COUNT + 1] = {};
+    int previous = -1;
+    for (int path : order) {
+        int path_bin = bin(path);
+        coherent_before += path_bin == previous;
+        previous = path_bin;
+        starts[path_bin + 1]++;
+    }
+    for (int i = 0; i < bin_count; i++) {
+        coherent_after += std::max(starts[i + 1] - 1, 0);
+        starts[i + 1] += starts[i];
+    }
+    scratch.resize(order.size());
+    for (int path : order) {
+        scratch[starts[bin(path)]++] = path;
+    }
+    order.swap(scratch);
+}
+
+// getRayColor for a whole wave of paths, a bounce at a time. Before every hit test the paths are binned by the octant
+// of their ray, so the BVH is walked in a similar order, and before shading by the material they hit. Every path keeps
+// its own sampler, so it ends with the same radiance as getRayColor gives it
+void traceWave(const CPUScene& scene, std::vector<PathState>& paths, const Uniforms& uniforms, RayCoherence& coherence, std::vector<int>& order, std::vector<int>& scratch) {
+    order.resize(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    for (int i = 0; i < uniforms.light_bounces && !order.empty(); i++) {
+        sortPaths(order, scratch, OCTANT_COUNT, [&](int path) { return directionOctant(paths[path].ray.direction); },
+            coherence.octant_arrived, coherence.octant_sorted);
+        coherence.intersected += order.size();
+        for (int path : order) {
+            paths[path].rec = {};
+            paths[path].hit = hit(scene, paths[path].ray, Interval{ 0.001f, INFINITY }, paths[path].rec);
+        }
+
+        sortPaths(order, scratch, MATERIAL_BIN_COUNT, [&](int path) { return paths[path].hit ? static_cast<int>(paths[path].rec.material.type) : MATERIAL_BIN_COUNT - 1; },
+            coherence.material_arrived, coherence.material_sorted);
+        coherence.shaded += order.size();
+        size_t alive = 0;
+        for (size_t j = 0; j < order.size(); ++j) {
+            if (shadePath(scene, paths[order[j]], i, uniforms)) {
+                order[alive++] = order[j];
+            }
+        }
+        order.resize(alive);
+    }
+    // Out of bounces
+    for (int path : order) {
+        paths[path].radiance += paths[path].color;
+    }
+}
+
+}
+
+bool RunMaterialBenchmark(unsigned int seed) {
+    CPUScene scene;
+    Scene preset = CreatePreset2(seed);
+    scene.Build(preset.objects, preset.meshes);
+
+    // Hits on random objects of the preset, from random directions towards the surface
+    struct BenchmarkHit {
+        Ray r_in;
+        HitRecord rec;
+    };
+    const int hit_count = 1 << 16;
+    std::mt19937 gen(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_int_distribution<int> slots(0, static_cast<int>(scene.shapes.size()) - 1);
+    std::vector<BenchmarkHit> random_order(hit_count);
+    for (BenchmarkHit& hit : random_order) {
+        hit.rec.object = slots(gen);
+        hit.rec.material = scene.material_table[scene.materials[hit.rec.object]];
+        hit.rec.normal = glm::normalize(glm::vec3(normal(gen), normal(gen), normal(gen)));
+        hit.rec.p = glm::vec3(normal(gen), normal(gen), normal(gen));
+        hit.rec.front_face = gen() & 1;
+        hit.r_in.origin = hit.rec.p + glm::vec3(normal(gen), normal(gen), normal(gen));
+        hit.r_in.direction = glm::normalize(glm::vec3(normal(gen), normal(gen), normal(gen)));
+        if (glm::dot(hit.r_in.direction, hit.rec.normal) > 0.0f) {
+            hit.r_in.direction = -hit.r_in.direction;
+        }
+    }
+    std::vector<BenchmarkHit> sorted_order = random_order;
+    std::stable_sort(sorted_order.begin(), sorted_order.end(), [](const BenchmarkHit& a, const BenchmarkHit& b) {
+        return a.rec.material.type < b.rec.material.type;
+    });
+
+    const int repeats = 16;
+    bool agree = true;
+    std::cout << "order     switch M/s   visit M/s" << std::endl;
+    for (const auto& order : { std::make_pair("random", &random_order), std::make_pair("sorted", &sorted_order) }) {
+        const std::vector<BenchmarkHit>& hits = *order.second;
+        std::vector<glm::vec3> directions[2];
+        double rates[2];
+        for (int visit = 0; visit < 2; ++visit) {
+            directions[visit].resize(hits.size());
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int repeat = 0; repeat < repeats; ++repeat) {
+                for (size_t i = 0; i < hits.size(); ++i) {
+                    Sampler sampler = initSampler(glm::uvec2(static_cast<uint32_t>(i), 0), repeat, 0, SamplerType::Random, nullptr);
+                    glm::vec3 attenuation;
+                    Ray scattered;
+                    if (visit) {
+                        scatter(scene.material_variants[scene.materials[hits[i].rec.object]], hits[i].r_in, hits[i].rec, attenuation, scattered, sampler);
+                    }
+                    else {
+                        scatter(hits[i].r_in, hits[i].rec, attenuation, scattered, sampler);
+                    }
+                    directions[visit][i] = scattered.direction * attenuation;
+                }
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            rates[visit] = repeats * hits.size() / seconds / 1e6;
+        }
+        agree = agree && directions[0] == directions[1];
+        std::cout << std::left << std::setw(8) << order.first << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << rates[0] << std::setw(12) << rates[1] << std::endl;
+    }
+    std::cout << (agree ? "Both scatter the same rays" : "The dispatches disagree") << std::endl;
+    return agree;
+}
+
+CPURenderer::CPURenderer(int light_bounces, int thread_count, SamplerType sampler, int roulette_depth, int tile_size)
+    : light_bounces{ light_bounces }, scheduler{ thread_count, tile_size }, sampler{ sampler }, roulette_depth{ roulette_depth }, sky_horizon{ 0 }, sky_zenith{ 0 }, pixel00{ 0 }, pixel_delta_u{ 0 }, pixel_delta_v{ 0 }, camera_center{ 0 },
+    frame{ 0 }, samples_per_pixel{ 0 }, width{ 0 }, height{ 0 }, sort_rays{ false }, coherence{} {}
+
+void CPURenderer::Render(const Scene& scene, int render_width, int render_height, int render_samples, unsigned int render_frame) {
+    cpu_scene.Build(scene.objects, scene.meshes);
+    sky_horizon = scene.sky_horizon;
+    sky_zenith = scene.sky_zenith;
+    if (sampler == SamplerType::BlueNoise && blue_noise.empty()) {
+        blue_noise = GenerateBlueNoise();
+    }
+    // Same camera math as the GPU path
+    Camera camera(static_cast<float>(render_width), static_cast<float>(render_height), 5.0f, 0.05f, 0.25f, scene.vfov, scene.look_from, scene.look_at);
+    pixel00 = camera.pixel00_loc;
+    pixel_delta_u = camera.pixel_delta_u;
+    pixel_delta_v = camera.pixel_delta_v;
+    camera_center = camera.camera_center;
+    frame = render_frame;
+    samples_per_pixel = render_samples;
+    width = render_width;
+    height = render_height;
+    radiance.assign(static_cast<size_t>(width) * height, glm::vec3(0.0f));
+    coherence = {};
+
+    // Every pixel seeds its own samples, so the image is the same whichever thread renders a tile
+    scheduler.Run(width, height, [this](const Tile& tile) { RenderTile(tile); });
+}
+
+void CPURenderer::RenderTile(const Tile& tile) {
+    Uniforms uniforms = { light_bounces, roulette_depth, sky_horizon, sky_zenith, cpu_scene.lights.data(), static_cast<int>(cpu_scene.lights.size()) };
+    auto camera_ray = [this](int x, int y, Sampler& sampler) {
+        // gl_FragCoord is the pixel centre, then getRay and pixelSampleSquare
+        glm::vec2 frag_coord(x + 0.5f, y + 0.5f);
+        glm::vec2 jitter = sample2D(sampler);
+        float px = jitter.x - 0.5f;
+        float py = jitter.y - 0.5f;
+        glm::vec3 pixel_center = pixel00 + (frag_coord.x * pixel_delta_u) + (frag_coord.y * pixel_delta_v);
+        glm::vec3 pixel_sample = pixel_center + (px * pixel_delta_u) + (py * pixel_delta_v);
+        return Ray{ camera_center, pixel_sample - camera_center };
+    };
+
+    if (!sort_rays) {
+        for (int y = tile.min.y; y < tile.max.y; ++y) {
+            for (int x = tile.min.x; x < tile.max.x; ++x) {
+                glm::vec3 pixel_color(0.0f);
+                for (int sample_index = 0; sample_index < samples_per_pixel; sample_index++) {
+                    Sampler sampler = initSampler(glm::uvec2(x, y), sample_index, frame, this->sampler, blue_noise.data());
+                    Ray r = camera_ray(x, y, sampler);
+                    pixel_color += getRayColor(cpu_scene, r, uniforms, sampler);
+                }
+                radiance[static_cast<size_t>(y) * width + x] = pixel_color / static_cast<float>(samples_per_pixel);
+            }
+        }
+        return;
+    }
+
+    // The paths of as many samples of every pixel of the tile as fit in a wave are traced together
+    glm::ivec2 size = tile.max - tile.min;
+    int pixel_count = size.x * size.y;
+    int wave_samples = std::max(1, std::min(samples_per_pixel, CPU_WAVE_SIZE / pixel_count));
+    std::vector<glm::vec3> pixel_colors(pixel_count, glm::vec3(0.0f));
+    std::vector<PathState> paths;
+    std::vector<int> order;
+    std::vector<int> scratch;
+    RayCoherence tile_coherence = {};
+    for (int first_sample = 0; first_sample < samples_per_pixel; first_sample += wave_samples) {
+        int sample_count = std::min(wave_samples, samples_per_pixel - first_sample);
+        paths.clear();
+        for (int pixel = 0; pixel < pixel_count; ++pixel) {
+            int x = tile.min.x + pixel % size.x;
+            int y = tile.min.y + pixel / size.x;
+            for (int sample_index = first_sample; sample_index < first_sample + sample_count; sample_index++) {
+                PathState path = { Ray{}, glm::vec3(1.0f), glm::vec3(0.0f), 0.0f,
+                    initSampler(glm::uvec2(x, y), sample_index, frame, this->sampler, blue_noise.data()), HitRecord{}, false };
+                path.ray = camera_ray(x, y, path.sampler);
+                paths.push_back(path);
+            }
+        }
+        traceWave(cpu_scene, paths, uniforms, tile_coherence, order, scratch);
+        // Added up in sample order like the loop above, so both give the same image
+        for (int pixel = 0; pixel < pixel_count; ++pixel) {
+            for (int sample = 0; sample < sample_count; ++sample) {
+                pixel_colors[pixel] += paths[static_cast<size_t>(pixel) * sample_count + sample].radiance;
+            }
+        }
+    }
+    for (int pixel = 0; pixel < pixel_count; ++pixel) {
+        int x = tile.min.x + pixel % size.x;
+        int y = tile.min.y + pixel / size.x;
+        radiance[static_cast<size_t>(y) * width + x] = pixel_colors[pixel] / static_cast<float>(samples_per_pixel);
+    }
+
+    std::lock_guard<std::mutex> lock(coherence_mutex);
+    coherence.intersected += tile_coherence.intersected;
+    coherence.octant_arrived += tile_coherence.octant_arrived;
+    coherence.octant_sorted += tile_coherence.octant_sorted;
+    coherence.shaded += tile_coherence.shaded;
+    coherence.material_arrived += tile_coherence.material_arrived;
+    coherence.material_sorted += tile_coherence.material_sorted;
+}
+
+std::vector<float> CPURenderer::ReadRadiance() const {
+    std::vector<float> pixels(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        const glm::vec3* row = radiance.data() + static_cast<size_t>(height - 1 - y) * width;
+        for (int x = 0; x < width; ++x) {
+            size_t index = (static_cast<size_t>(y) * width + x) * 3;
+            pixels[index + 0] = row[x].r;
+            pixels[index + 1] = row[x].g;
+            pixels[index + 2] = row[x].b;
+        }
+    }
+    return pixels;
+}
+
+//Getters
+int CPURenderer::GetThreadCount() const {
+    return scheduler.GetThreadCount();
+}
+
+int CPURenderer::GetTileSize() const {
+    return scheduler.GetTileSize();
+}
+
+int CPURenderer::GetStolenTiles() const {
+    return scheduler.GetStolenTiles();
+}
+
+RayCoherence CPURenderer::GetRayCoherence() const {
+    return coherence;
+}
+
+//Setters
+void CPURenderer::SetRaySorting(bool sort) {
+    sort_rays = sort;
+}
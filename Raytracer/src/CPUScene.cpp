@@ -0,0 +1,70 @@
+#include <map>
+#include <memory>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "../include/CPUScene.h"
+#include "../include/Scene.h"
+
+MaterialVariant ToMaterialVariant(const Material& material) {
+    switch (material.type) {
+    case MaterialType::Lambertian:
+        return Lambertian{ material.albedo };
+    case MaterialType::Metal:
+        return Metal{ material.albedo, material.fuzz };
+    case MaterialType::Dielectric:
+        return Dielectric{ material.refraction_index };
+    default:
+        return Absorbing{};
+    }
+}
+
+void CPUScene::Build(const std::vector<Object>& objects, const std::vector<std::shared_ptr<const Mesh>>& scene_meshes) {
+    meshes = scene_meshes;
+    bvh.Build(objects, meshes);
+    spheres.Build(objects, bvh);
+
+    // Same keys as SceneBuffer::FindMaterial, so both backends share out the same table
+    std::map<std::tuple<int, float, float, float, float, float>, int> material_indices;
+    material_table.clear();
+    material_variants.clear();
+    const std::vector<int>& primitive_indices = bvh.GetPrimitiveIndices();
+    size_t slot_count = primitive_indices.size();
+    shapes.resize(slot_count);
+    materials.resize(slot_count);
+    slot_meshes.assign(slot_count, nullptr);
+    rotations.assign(slot_count, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        const Object& object = objects[primitive_indices[slot]];
+        shapes[slot] = ObjectShape{ object.position, object.scale.x, object.scale, object.type };
+        // The BVH leaves out mesh objects without a mesh
+        if (object.type == ObjectType::Mesh) {
+            slot_meshes[slot] = meshes[object.mesh].get();
+            rotations[slot] = InstanceRotation(object);
+        }
+
+        const Material& material = object.material;
+        auto key = std::make_tuple(static_cast<int>(material.type), material.albedo.r, material.albedo.g, material.albedo.b, material.fuzz, material.refraction_index);
+        auto found = material_indices.find(key);
+        if (found == material_indices.end()) {
+            found = material_indices.emplace(key, static_cast<int>(material_table.size())).first;
+            material_table.push_back(material);
+            material_variants.push_back(ToMaterialVariant(material));
+        }
+        materials[slot] = found->second;
+    }
+
+    // Spheres and quads always have bounds, so every light has a slot
+    std::vector<int> slots(objects.size(), -1);
+    for (size_t slot = 0; slot < slot_count; ++slot) {
+        slots[primitive_indices[slot]] = static_cast<int>(slot);
+    }
+    lights.clear();
+    for (int light : FindLights(objects)) {
+        lights.push_back(slots[light]);
+    }
+}
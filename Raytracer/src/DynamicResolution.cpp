@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+
+#include "../include/DynamicResolution.h"
+
+// The pass is resized when its predicted time leaves [LOW_WATERMARK, 1] * target, and then aimed at AIM * target.
+// The gap between the two keeps noisy timings from flipping the resolution back and forth
+const double LOW_WATERMARK = 0.7;
+const double AIM = 0.85;
+// Weight of the newest timing in the smoothed cost per sample
+const double COST_SMOOTHING = 0.3;
+
+DynamicResolution::DynamicResolution(float target_ms, float min_scale, bool adjust_samples)
+    : scale{ 1.0f }, samples{ 0 }, cost_per_sample{ 0 }, still_frames{ DYNAMIC_RESOLUTION_SETTLE_FRAMES },
+    target_ms{ target_ms }, min_scale{ min_scale }, adjust_samples{ adjust_samples } {}
+
+void DynamicResolution::AddMeasurement(double milliseconds, long long pass_samples) {
+    if (milliseconds <= 0 || pass_samples <= 0) {
+        return;
+    }
+    double cost = milliseconds / pass_samples;
+    cost_per_sample = cost_per_sample == 0 ? cost : cost_per_sample + COST_SMOOTHING * (cost - cost_per_sample);
+}
+
+bool DynamicResolution::Update(bool camera_moved, float max_scale, int max_samples, int window_width, int window_height) {
+    float old_scale = GetScale(max_scale);
+    int old_samples = GetSamples(max_samples);
+
+    if (!camera_moved) {
+        still_frames = std::min(still_frames + 1, DYNAMIC_RESOLUTION_SETTLE_FRAMES);
+    }
+    else {
+        // Movement resumes at the last dynamic scale rather than at full resolution
+        still_frames = 0;
+        if (samples == 0) {
+            samples = max_samples;
+        }
+        scale = std::min(scale, max_scale);
+        samples = std::min(samples, max_samples);
+
+        if (cost_per_sample > 0) {
+            double pixels = static_cast<double>(window_width) * window_height;
+            double predicted = cost_per_sample * pixels * scale * scale * samples;
+            if (predicted > target_ms || predicted < target_ms * LOW_WATERMARK) {
+                double budget = target_ms * AIM / cost_per_sample; // samples per pass
+                int new_samples = max_samples;
+                float new_scale = static_cast<float>(std::sqrt(budget / (pixels * new_samples)));
+                if (adjust_samples && new_scale < min_scale) {
+                    // Resolution is at its floor, trade samples instead
+                    new_scale = min_scale;
+                    new_samples = std::clamp(static_cast<int>(budget / (pixels * min_scale * min_scale)), 1, max_samples);
+                }
+                scale = std::clamp(std::floor(new_scale / DYNAMIC_RESOLUTION_STEP) * DYNAMIC_RESOLUTION_STEP, min_scale, max_scale);
+                samples = new_samples;
+            }
+        }
+    }
+
+    return GetScale(max_scale) != old_scale || GetSamples(max_samples) != old_samples;
+}
+
+void DynamicResolution::Reset(float max_scale, int max_samples) {
+    scale = max_scale;
+    samples = max_samples;
+    cost_per_sample = 0;
+    still_frames = DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+}
+
+//Getters
+bool DynamicResolution::IsSettled() const {
+    return still_frames >= DYNAMIC_RESOLUTION_SETTLE_FRAMES;
+}
+
+float DynamicResolution::GetScale(float max_scale) const {
+    return IsSettled() ? max_scale : std::min(scale, max_scale);
+}
+
+int DynamicResolution::GetSamples(int max_samples) const {
+    return IsSettled() || samples == 0 ? max_samples : std::min(samples, max_samples);
+}
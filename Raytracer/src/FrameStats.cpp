@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "../include/FrameStats.h"
+
+FrameStats::FrameStats() : history{}, count{ 0 }, offset{ 0 } {}
+
+void FrameStats::Add(float value) {
+    if (count < FRAME_STATS_HISTORY) {
+        history[count++] = value;
+    }
+    else {
+        history[offset] = value;
+        offset = (offset + 1) % FRAME_STATS_HISTORY;
+    }
+}
+
+void FrameStats::Clear() {
+    count = 0;
+    offset = 0;
+}
+
+//Getters
+float FrameStats::GetLatest() const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    return history[(offset + count - 1) % FRAME_STATS_HISTORY];
+}
+
+float FrameStats::GetMin() const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    return *std::min_element(history, history + count);
+}
+
+float FrameStats::GetAverage() const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    double sum = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += history[i];
+    }
+    return static_cast<float>(sum / count);
+}
+
+float FrameStats::GetPercentile(float percentile) const {
+    if (count == 0) {
+        return 0.0f;
+    }
+    // Nearest rank on a copy, the history has to stay in order for plotting
+    std::vector<float> sorted(history, history + count);
+    int rank = std::clamp(static_cast<int>(std::ceil(percentile / 100.0f * count)) - 1, 0, count - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+const float* FrameStats::GetHistory() const {
+    return history;
+}
+
+int FrameStats::GetCount() const {
+    return count;
+}
+
+int FrameStats::GetOffset() const {
+    return offset;
+}
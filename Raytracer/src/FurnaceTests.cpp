@@ -0,0 +1,140 @@
+#include <GL/glew.h>
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/FurnaceTests.h"
+#include "../include/Camera.h"
+#include "../include/CPURenderer.h"
+#include "../include/Mesh.h"
+#include "../include/Renderer.h"
+#include "../include/Scene.h"
+
+namespace {
+
+const float FURNACE_ALBEDO = 0.5f;
+
+// Renders a scene, returns the radiance top row first as RGB
+typedef std::function<std::vector<float>(const Scene&)> Backend;
+
+struct FurnaceResult {
+    double bias_up;     // mean of rendered - analytic where the normal faces up
+    double bias_down;   // the same where it faces down
+    // Bias a bounce spread uniformly over the hemisphere would have instead, its mean direction is 1/2 of the normal.
+    // 0 under a uniform sky, where every hemisphere sampler gives the albedo
+    double uniform_bias_up;
+    double uniform_bias_down;
+};
+
+// A furnace render and what it checks. A tolerance of 0 takes a quarter of the uniform bias of the scene, so that
+// bounces spread uniformly over the hemisphere instead of by the cosine fail it
+struct FurnaceCase {
+    const char* name;
+    const char* guards;
+    Scene scene;
+    double tolerance;
+};
+
+// Radiance a cosine weighted bounce gathers from a sky that is linear in the direction, through the pixel centres
+FurnaceResult Measure(const Scene& scene, const std::vector<float>& radiance) {
+    Camera camera(FURNACE_TEST_WIDTH, FURNACE_TEST_HEIGHT, 5.0f, 0.05f, 0.25f, scene.vfov, scene.look_from, scene.look_at);
+    glm::vec3 sky_slope = 0.5f * (scene.sky_zenith - scene.sky_horizon);
+    glm::vec3 sky_mean = 0.5f * (scene.sky_zenith + scene.sky_horizon);
+    double sum[2] = {}, uniform_sum[2] = {}, count[2] = {};
+    for (int row = 0; row < FURNACE_TEST_HEIGHT; ++row) {
+        for (int x = 0; x < FURNACE_TEST_WIDTH; ++x) {
+            int y = FURNACE_TEST_HEIGHT - 1 - row;
+            glm::vec3 pixel_center = camera.pixel00_loc + (x + 0.5f) * camera.pixel_delta_u + (y + 0.5f) * camera.pixel_delta_v;
+            glm::vec3 direction = glm::normalize(pixel_center - camera.camera_center);
+            // Unit sphere at the origin, the camera is outside it
+            float half_b = glm::dot(camera.camera_center, direction);
+            float discriminant = half_b * half_b - (glm::dot(camera.camera_center, camera.camera_center) - 1.0f);
+            if (discriminant < 0) {
+                continue;
+            }
+            glm::vec3 normal = camera.camera_center + (-half_b - std::sqrt(discriminant)) * direction;
+            // The mean of the bounce direction is 2/3 of the normal
+            glm::vec3 expected = FURNACE_ALBEDO * (sky_mean + sky_slope * (2.0f / 3.0f) * normal.y);
+            glm::vec3 uniform_expected = FURNACE_ALBEDO * (sky_mean + sky_slope * 0.5f * normal.y);
+            const float* pixel = &radiance[(static_cast<size_t>(row) * FURNACE_TEST_WIDTH + x) * 3];
+            int half = normal.y > 0 ? 0 : 1;
+            for (int channel = 0; channel < 3; ++channel) {
+                sum[half] += pixel[channel] - expected[channel];
+                uniform_sum[half] += uniform_expected[channel] - expected[channel];
+                count[half] += 1;
+            }
+        }
+    }
+    return FurnaceResult{ sum[0] / std::max(count[0], 1.0), sum[1] / std::max(count[1], 1.0),
+        uniform_sum[0] / std::max(count[0], 1.0), uniform_sum[1] / std::max(count[1], 1.0) };
+}
+
+}
+
+bool RunFurnaceTests(bool check_gpu) {
+    Scene uniform_sky = CreateFurnaceScene(FURNACE_ALBEDO);
+    // Radiance 1 + d.y, so the mean over any hemisphere is still 1
+    Scene gradient_sky = uniform_sky;
+    gradient_sky.sky_horizon = glm::vec3(0.0f);
+    gradient_sky.sky_zenith = glm::vec3(2.0f);
+    // A flat shaded icosphere instead of the sphere, which is just as convex. A ray slipping through an edge between two
+    // triangles brings back the whole sky instead of the albedo
+    Scene mesh_sky = uniform_sky;
+    mesh_sky.meshes.push_back(CreateIcosphere(3));
+    mesh_sky.objects[0].type = ObjectType::Mesh;
+    mesh_sky.objects[0].mesh = 0;
+    const FurnaceCase cases[] = {
+        { "uniform sky", "bounce weight", uniform_sky, FURNACE_TEST_TOLERANCE },
+        { "gradient sky", "cosine sampling", gradient_sky, 0.0 },
+        { "mesh", "watertight mesh", mesh_sky, FURNACE_TEST_TOLERANCE },
+    };
+
+    std::vector<std::pair<std::string, Backend>> backends;
+    CPURenderer cpu_renderer;
+    backends.push_back({ "cpu", [&](const Scene& scene) {
+        cpu_renderer.Render(scene, FURNACE_TEST_WIDTH, FURNACE_TEST_HEIGHT, FURNACE_TEST_SAMPLES);
+        return cpu_renderer.ReadRadiance();
+    } });
+    // The renderer frees its GL objects, so it is released before returning to the caller that owns the context
+    std::unique_ptr<Renderer> renderer;
+    if (check_gpu) {
+        auto camera = std::make_shared<Camera>();
+        renderer = std::make_unique<Renderer>(nullptr, camera, 20, 16, 1.0f, false);
+        renderer->camera = camera;
+        const std::pair<const char*, RenderPipeline> pipelines[] = { { "fragment", RenderPipeline::Fragment }, { "wavefront", RenderPipeline::Wavefront } };
+        for (const auto& pipeline : pipelines) {
+            RenderPipeline render_pipeline = pipeline.second;
+            backends.push_back({ pipeline.first, [&renderer, render_pipeline](const Scene& scene) {
+                renderer->SetPipeline(render_pipeline);
+                renderer->ApplyScene(scene);
+                renderer->RenderOffscreen(FURNACE_TEST_WIDTH, FURNACE_TEST_HEIGHT, FURNACE_TEST_SAMPLES);
+                return renderer->ReadRadiance(FURNACE_TEST_WIDTH, FURNACE_TEST_HEIGHT);
+            } });
+        }
+    }
+
+    bool passed = true;
+    std::printf("%-14s %-17s %-10s %12s %12s %9s\n", "furnace", "guards", "backend", "bias up", "bias down", "limit");
+    for (const FurnaceCase& furnace : cases) {
+        for (const auto& backend : backends) {
+            FurnaceResult result = Measure(furnace.scene, backend.second(furnace.scene));
+            double limit_up = furnace.tolerance > 0 ? furnace.tolerance : 0.25 * std::abs(result.uniform_bias_up);
+            double limit_down = furnace.tolerance > 0 ? furnace.tolerance : 0.25 * std::abs(result.uniform_bias_down);
+            bool ok = std::abs(result.bias_up) < limit_up && std::abs(result.bias_down) < limit_down;
+            std::printf("%-14s %-17s %-10s %12.5f %12.5f %9.5f %s\n", furnace.name, furnace.guards, backend.first.c_str(), result.bias_up, result.bias_down,
+                std::min(limit_up, limit_down), ok ? "" : "FAIL");
+            passed = passed && ok;
+        }
+    }
+    std::printf("The uniform sky gives the albedo for any hemisphere sampler, only the gradient sky checks the cosine weighting.\n"
+        "Its limit is a quarter of the bias of bounces spread uniformly over the hemisphere\n");
+    std::cout << (passed ? "Furnace tests passed" : "Furnace tests failed") << std::endl;
+    return passed;
+}
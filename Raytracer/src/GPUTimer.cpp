@@ -0,0 +1,111 @@
+#include <GL/glew.h>
+
+#include <deque>
+
+#include "../include/GPUTimer.h"
+
+GPUTimer::GPUTimer(bool count_rays) : slots{}, next_slot{ 0 }, count_rays{ count_rays } {}
+
+GPUTimer::~GPUTimer() {
+    Release();
+}
+
+void GPUTimer::Begin(long long samples) {
+    Slot& slot = slots[next_slot];
+    if (slot.query == 0) {
+        glGenQueries(1, &slot.query);
+        if (count_rays) {
+            glGenBuffers(1, &slot.ray_counter);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.ray_counter);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, RAY_COUNTER_SLOTS * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+    }
+    // Only stalls when passes are issued faster than the GPU finishes them, e.g. several in one frame
+    if (slot.pending) {
+        Read(slot);
+    }
+
+    if (count_rays) {
+        const GLuint zeros[RAY_COUNTER_SLOTS] = {};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.ray_counter);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zeros), zeros);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, RAY_COUNTER_BINDING, slot.ray_counter);
+    }
+    slot.samples = samples;
+    glBeginQuery(GL_TIME_ELAPSED, slot.query);
+}
+
+void GPUTimer::End() {
+    glEndQuery(GL_TIME_ELAPSED);
+    if (count_rays) {
+        // Make the shader's atomic writes visible to glGetBufferSubData
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    }
+    slots[next_slot].pending = true;
+    next_slot = (next_slot + 1) % GPU_TIMER_SLOTS;
+}
+
+bool GPUTimer::Collect(GPUTimerResult& result) {
+    // Slots are reused in order, so the oldest one in flight is the next one to be reused
+    for (int i = 0; i < GPU_TIMER_SLOTS; ++i) {
+        Slot& slot = slots[(next_slot + i) % GPU_TIMER_SLOTS];
+        if (!slot.pending) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(slot.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            Read(slot);
+        }
+        break;
+    }
+
+    if (ready.empty()) {
+        return false;
+    }
+    result = ready.front();
+    ready.pop_front();
+    return true;
+}
+
+void GPUTimer::Read(Slot& slot) {
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(slot.query, GL_QUERY_RESULT, &elapsed);
+
+    unsigned long long rays = 0;
+    if (count_rays) {
+        GLuint counts[RAY_COUNTER_SLOTS];
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, slot.ray_counter);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(counts), counts);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        for (GLuint count : counts) {
+            rays += count;
+        }
+    }
+    ready.push_back({ elapsed / 1e6, slot.samples, rays });
+    slot.pending = false;
+}
+
+void GPUTimer::Release() {
+    for (Slot& slot : slots) {
+        if (slot.query != 0) {
+            glDeleteQueries(1, &slot.query);
+        }
+        if (slot.ray_counter != 0) {
+            glDeleteBuffers(1, &slot.ray_counter);
+        }
+        slot = Slot{};
+    }
+    ready.clear();
+}
+
+//Getters
+int GPUTimer::GetLiveObjectCount() const {
+    int count = 0;
+    for (const Slot& slot : slots) {
+        count += (slot.query != 0) + (slot.ray_counter != 0);
+    }
+    return count;
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/Image.h"
+
+bool WritePPM(const std::string& path, int width, int height, const std::vector<unsigned char>& pixels) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open image file: " << path << std::endl;
+        return false;
+    }
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(width) * height * 3);
+    return file.good();
+}
+
+bool WritePFM(const std::string& path, int width, int height, const std::vector<float>& pixels) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open image file: " << path << std::endl;
+        return false;
+    }
+    // A negative scale marks little endian data, rows are stored from the bottom up
+    file << "PF\n" << width << " " << height << "\n-1.0\n";
+    for (int y = height - 1; y >= 0; --y) {
+        file.write(reinterpret_cast<const char*>(pixels.data() + static_cast<size_t>(y) * width * 3), static_cast<std::streamsize>(width) * 3 * sizeof(float));
+    }
+    return file.good();
+}
+
+std::vector<unsigned char> ApplyDisplayTransform(const std::vector<float>& radiance, Tonemapper tonemapper, float exposure, float gamma) {
+    std::vector<unsigned char> pixels(radiance.size());
+    float scale = std::exp2(exposure);
+    for (size_t i = 0; i < radiance.size(); ++i) {
+        float color = radiance[i] * scale;
+        switch (tonemapper) {
+        case Tonemapper::Reinhard:
+            color = color / (1.0f + color);
+            break;
+        case Tonemapper::ACES:
+            color = std::clamp((color * (2.51f * color + 0.03f)) / (color * (2.43f * color + 0.59f) + 0.14f), 0.0f, 1.0f);
+            break;
+        default:
+            color = std::clamp(color, 0.0f, 1.0f);
+            break;
+        }
+        color = std::pow(color, 1.0f / gamma);
+        pixels[i] = static_cast<unsigned char>(std::lround(std::clamp(color, 0.0f, 1.0f) * 255.0f));
+    }
+    return pixels;
+}
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/Mesh.h"
+
+void Mesh::Build() {
+    bvh.BuildTriangles(positions, triangles);
+    // The primitive indices keep the order the triangles were read in
+    const std::vector<int>& order = bvh.GetPrimitiveIndices();
+    std::vector<glm::uvec3> ordered(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        ordered[i] = triangles[order[i]];
+    }
+    triangles.swap(ordered);
+}
+
+// OBJ indices count from 1, negative ones count back from the last element read so far
+static bool ResolveIndex(long index, size_t count, uint32_t& resolved) {
+    if (index > 0 && static_cast<size_t>(index) <= count) {
+        resolved = static_cast<uint32_t>(index - 1);
+        return true;
+    }
+    if (index < 0 && static_cast<size_t>(-index) <= count) {
+        resolved = static_cast<uint32_t>(count + index);
+        return true;
+    }
+    return false;
+}
+
+// Reads up to count floats, returns false if fewer are there
+static bool ReadFloats(const char*& cursor, float* values, int count) {
+    for (int i = 0; i < count; ++i) {
+        char* end;
+        values[i] = std::strtof(cursor, &end);
+        if (end == cursor) {
+            return false;
+        }
+        cursor = end;
+    }
+    return true;
+}
+
+bool LoadOBJ(const std::string& path, Mesh& mesh) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open OBJ file: " << path << std::endl;
+        return false;
+    }
+
+    mesh = Mesh();
+    size_t name_start = path.find_last_of("/\\");
+    mesh.name = path.substr(name_start == std::string::npos ? 0 : name_start + 1);
+
+    std::vector<glm::vec3> file_positions;
+    std::vector<glm::vec3> file_normals;
+    // (position, normal + 1) of every vertex made so far, 0 standing for no normal
+    std::unordered_map<uint64_t, uint32_t> vertices;
+    std::vector<uint32_t> face;
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        const char* cursor = line.c_str();
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+
+        bool valid = true;
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            glm::vec3 position;
+            cursor += 1;
+            valid = ReadFloats(cursor, &position.x, 3);
+            file_positions.push_back(position);
+        }
+        else if (cursor[0] == 'v' && cursor[1] == 'n' && (cursor[2] == ' ' || cursor[2] == '\t')) {
+            glm::vec3 normal;
+            cursor += 2;
+            valid = ReadFloats(cursor, &normal.x, 3);
+            file_normals.push_back(glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : normal);
+        }
+        else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            // Every corner is position, position/texture, position//normal or position/texture/normal
+            face.clear();
+            cursor += 1;
+            while (valid) {
+                char* end;
+                long position_index = std::strtol(cursor, &end, 10);
+                if (end == cursor) {
+                    break;
+                }
+                cursor = end;
+                long normal_index = 0;
+                if (*cursor == '/') {
+                    ++cursor;
+                    if (*cursor != '/') {
+                        std::strtol(cursor, &end, 10);
+                        cursor = end;
+                    }
+                    if (*cursor == '/') {
+                        ++cursor;
+                        normal_index = std::strtol(cursor, &end, 10);
+                        valid = end != cursor;
+                        cursor = end;
+                    }
+                }
+
+                uint32_t position = 0;
+                uint32_t normal = 0;
+                valid = valid && ResolveIndex(position_index, file_positions.size(), position);
+                valid = valid && (normal_index == 0 || ResolveIndex(normal_index, file_normals.size(), normal));
+                if (!valid) {
+                    break;
+                }
+                uint64_t key = (static_cast<uint64_t>(position) << 32) | (normal_index == 0 ? 0u : normal + 1u);
+                auto vertex = vertices.find(key);
+                if (vertex == vertices.end()) {
+                    vertex = vertices.emplace(key, static_cast<uint32_t>(mesh.positions.size())).first;
+                    mesh.positions.push_back(file_positions[position]);
+                    mesh.normals.push_back(normal_index == 0 ? glm::vec3(0.0f) : file_normals[normal]);
+                }
+                face.push_back(vertex->second);
+            }
+            valid = valid && face.size() >= 3;
+            for (size_t i = 2; valid && i < face.size(); ++i) {
+                mesh.triangles.push_back(glm::uvec3(face[0], face[i - 1], face[i]));
+            }
+        }
+
+        if (!valid) {
+            std::cerr << path << ":" << line_number << ": invalid OBJ entry: " << line << std::endl;
+            return false;
+        }
+    }
+
+    if (mesh.triangles.empty()) {
+        std::cerr << "No faces in OBJ file: " << path << std::endl;
+        return false;
+    }
+    mesh.Build();
+    return true;
+}
+
+glm::quat InstanceRotation(const Object& object) {
+    // Euler angles in glm apply x first and z last
+    return glm::quat(glm::radians(object.rotation));
+}
+
+std::shared_ptr<Mesh> CreateIcosphere(int subdivisions) {
+    auto mesh = std::make_shared<Mesh>();
+    mesh->name = "icosphere";
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    const glm::vec3 corners[] = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+        { 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+        { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+    for (const glm::vec3& corner : corners) {
+        mesh->positions.push_back(glm::normalize(corner));
+    }
+    mesh->triangles = {
+        { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+        { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+        { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+        { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+    };
+
+    for (int level = 0; level < subdivisions; ++level) {
+        // Both faces along an edge get the same midpoint vertex, so the surface stays closed
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            auto edge = std::make_pair(std::min(a, b), std::max(a, b));
+            auto found = midpoints.find(edge);
+            if (found != midpoints.end()) {
+                return found->second;
+            }
+            uint32_t index = static_cast<uint32_t>(mesh->positions.size());
+            mesh->positions.push_back(glm::normalize(mesh->positions[a] + mesh->positions[b]));
+            midpoints[edge] = index;
+            return index;
+        };
+        std::vector<glm::uvec3> split;
+        split.reserve(4 * mesh->triangles.size());
+        for (const glm::uvec3& triangle : mesh->triangles) {
+            uint32_t ab = midpoint(triangle.x, triangle.y);
+            uint32_t bc = midpoint(triangle.y, triangle.z);
+            uint32_t ca = midpoint(triangle.z, triangle.x);
+            split.push_back({ triangle.x, ab, ca });
+            split.push_back({ triangle.y, bc, ab });
+            split.push_back({ triangle.z, ca, bc });
+            split.push_back({ ab, bc, ca });
+        }
+        mesh->triangles.swap(split);
+    }
+
+    mesh->normals.assign(mesh->positions.size(), glm::vec3(0.0f));
+    mesh->Build();
+    return mesh;
+}
@@ -0,0 +1,107 @@
+#include <iostream>
+
+#ifdef _WIN32
+#include <GLFW/glfw3.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "../include/OffscreenContext.h"
+
+OffscreenContext::OffscreenContext() : display{ nullptr }, context{ nullptr } {}
+
+OffscreenContext::~OffscreenContext() {
+    Destroy();
+}
+
+#ifdef _WIN32
+
+bool OffscreenContext::Create() {
+    if (!glfwInit()) {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return false;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(1, 1, "raytracer-render", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Failed to create hidden window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    context = window;
+    return true;
+}
+
+void OffscreenContext::Destroy() {
+    if (context) {
+        glfwDestroyWindow(static_cast<GLFWwindow*>(context));
+        glfwTerminate();
+        context = nullptr;
+    }
+}
+
+#else
+
+bool OffscreenContext::Create() {
+    // Prefer Mesa's surfaceless platform, it needs neither X11 nor a GPU
+    EGLDisplay egl_display = EGL_NO_DISPLAY;
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display) {
+        egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (egl_display == EGL_NO_DISPLAY) {
+        egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, nullptr, nullptr)) {
+        std::cerr << "Failed to initialize EGL" << std::endl;
+        return false;
+    }
+    display = egl_display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+        Destroy();
+        return false;
+    }
+
+    // Rendering only ever goes to framebuffer objects, so no surface or config is needed
+    const EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext egl_context = eglCreateContext(egl_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes);
+    if (egl_context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create an OpenGL 4.3 context (EGL error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        Destroy();
+        return false;
+    }
+    context = egl_context;
+
+    if (!eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context)) {
+        std::cerr << "Failed to make the OpenGL context current" << std::endl;
+        Destroy();
+        return false;
+    }
+    return true;
+}
+
+void OffscreenContext::Destroy() {
+    if (display) {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context) {
+            eglDestroyContext(display, context);
+        }
+        eglTerminate(display);
+    }
+    display = nullptr;
+    context = nullptr;
+}
+
+#endif
@@ -0,0 +1,58 @@
+#include <cstdint>
+
+#include "../include/Random.h"
+
+uint32_t PCGNext(uint32_t& state) {
+    state = state * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+uint32_t PCGHash(uint32_t value) {
+    return PCGNext(value);
+}
+
+uint32_t InitRandom(uint32_t x, uint32_t y, uint32_t sample_index, uint32_t frame) {
+    return PCGHash(x + PCGHash(y + PCGHash(sample_index + PCGHash(frame))));
+}
+
+float RandomFloat(uint32_t& state) {
+    return ToUnitFloat(PCGNext(state));
+}
+
+float ToUnitFloat(uint32_t bits) {
+    // The top 24 bits convert to a float exactly, so the GPU rounds the same way
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+uint32_t ReverseBits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// Base 2 Owen scrambling as a hash (Burley, Practical Hash-based Owen Scrambling)
+static uint32_t LaineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x ^= x * 0x3d20adeau;
+    x += seed;
+    x *= (seed >> 16) | 1u;
+    x ^= x * 0x05526c56u;
+    x ^= x * 0x53a22864u;
+    return x;
+}
+
+uint32_t NestedUniformScramble(uint32_t x, uint32_t seed) {
+    return ReverseBits(LaineKarrasPermutation(ReverseBits(x), seed));
+}
+
+uint32_t Sobol1(uint32_t index) {
+    uint32_t result = 0;
+    for (uint32_t v = 1u << 31; index != 0; index >>= 1, v ^= v >> 1) {
+        if (index & 1u) {
+            result ^= v;
+        }
+    }
+    return result;
+}
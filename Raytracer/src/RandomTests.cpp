@@ -0,0 +1,183 @@
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <utility>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/RandomTests.h"
+#include "../include/Random.h"
+#include "../include/Shader.h"
+
+namespace {
+
+// Largest chi-square over 64 bins (63 degrees of freedom) at p = 0.001
+const double CHI_SQUARE_LIMIT = 103.4;
+
+// Draw number `draw` of one sample, the first two jitter the camera ray and each bounce takes the next two
+typedef std::function<float(int x, int y, int sample_index, int frame, int draw)> Generator;
+// Two draws that should be independent, taken for a pixel of the test image
+typedef std::function<std::pair<float, float>(const Generator& generator, int x, int y)> DrawPair;
+
+float PCGDraw(int x, int y, int sample_index, int frame, int draw) {
+    uint32_t state = InitRandom(x, y, sample_index, frame);
+    float value = 0;
+    for (int i = 0; i <= draw; ++i) {
+        value = RandomFloat(state);
+    }
+    return value;
+}
+
+// The generator before PCG: a sin hash of (time, distance of the pixel from the origin + sample).
+// The seed never changed within a sample, so every bounce drew the same two numbers
+float SinHashDraw(int x, int y, int sample_index, int frame, int draw) {
+    glm::vec2 seed(static_cast<float>(frame), glm::length(glm::vec4(x + 0.5f, y + 0.5f, 0.5f, 1.0f)) * 0.1f + sample_index);
+    if (draw % 2 == 1) {
+        seed *= 0.5f;
+    }
+    return glm::fract(std::sin(glm::dot(seed, glm::vec2(12.9898f, 78.233f))) * 43758.5453f);
+}
+
+double Correlation(const std::vector<double>& a, const std::vector<double>& b) {
+    double mean_a = 0, mean_b = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        mean_a += a[i];
+        mean_b += b[i];
+    }
+    mean_a /= a.size();
+    mean_b /= b.size();
+    double covariance = 0, variance_a = 0, variance_b = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        covariance += (a[i] - mean_a) * (b[i] - mean_b);
+        variance_a += (a[i] - mean_a) * (a[i] - mean_a);
+        variance_b += (b[i] - mean_b) * (b[i] - mean_b);
+    }
+    if (variance_a == 0 || variance_b == 0) {
+        return 1.0; // a constant sequence is as correlated as it gets
+    }
+    return covariance / std::sqrt(variance_a * variance_b);
+}
+
+// Pearson correlation between two draws taken at every pixel of the test image
+double PairCorrelation(const Generator& generator, const DrawPair& draw_pair) {
+    std::vector<double> a, b;
+    for (int y = 0; y < RANDOM_TEST_SIZE; ++y) {
+        for (int x = 0; x < RANDOM_TEST_SIZE; ++x) {
+            std::pair<float, float> draws = draw_pair(generator, x, y);
+            a.push_back(draws.first);
+            b.push_back(draws.second);
+        }
+    }
+    return Correlation(a, b);
+}
+
+double ChiSquare(const Generator& generator) {
+    const int bins = 64;
+    std::vector<double> counts(bins, 0.0);
+    int total = 0;
+    for (int y = 0; y < RANDOM_TEST_SIZE; ++y) {
+        for (int x = 0; x < RANDOM_TEST_SIZE; ++x) {
+            for (int draw = 0; draw < RANDOM_TEST_DRAWS; ++draw) {
+                int bin = static_cast<int>(generator(x, y, 0, 1, draw) * bins);
+                counts[std::min(bin, bins - 1)] += 1;
+                ++total;
+            }
+        }
+    }
+    double expected = static_cast<double>(total) / bins;
+    double chi_square = 0;
+    for (double count : counts) {
+        chi_square += (count - expected) * (count - expected) / expected;
+    }
+    return chi_square;
+}
+
+bool CheckGPU() {
+    const int pixel_count = RANDOM_TEST_SIZE * RANDOM_TEST_SIZE;
+    const int sample_index = 3;
+    const unsigned int frame = 7;
+    Shader shader("shaders/random_test.cs.glsl");
+    if (shader.GetId() == 0) {
+        return false;
+    }
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, pixel_count * RANDOM_TEST_DRAWS * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, buffer);
+
+    shader.Use();
+    glUniform1i(glGetUniformLocation(shader.GetId(), "u_width"), RANDOM_TEST_SIZE);
+    glUniform1i(glGetUniformLocation(shader.GetId(), "u_sampleIndex"), sample_index);
+    glUniform1ui(glGetUniformLocation(shader.GetId(), "u_frame"), frame);
+    glDispatchCompute(pixel_count / 64, 1, 1);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    std::vector<GLuint> gpu(pixel_count * RANDOM_TEST_DRAWS);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, gpu.size() * sizeof(GLuint), gpu.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+
+    int mismatches = 0;
+    for (int pixel = 0; pixel < pixel_count; ++pixel) {
+        uint32_t state = InitRandom(pixel % RANDOM_TEST_SIZE, pixel / RANDOM_TEST_SIZE, sample_index, frame);
+        for (int i = 0; i < RANDOM_TEST_DRAWS; ++i) {
+            uint32_t expected;
+            if (i < RANDOM_TEST_DRAWS - 1) {
+                expected = PCGNext(state);
+            }
+            else {
+                float value = RandomFloat(state);
+                std::memcpy(&expected, &value, sizeof(expected));
+            }
+            mismatches += gpu[pixel * RANDOM_TEST_DRAWS + i] != expected;
+        }
+    }
+    std::cout << "GPU and CPU draws: " << mismatches << " of " << gpu.size() << " differ" << std::endl;
+    return mismatches == 0;
+}
+
+}
+
+bool RunRandomTests(bool check_gpu) {
+    const double pixel_count = RANDOM_TEST_SIZE * RANDOM_TEST_SIZE;
+    // Four standard errors of the correlation of independent draws
+    const double correlation_limit = 4.0 / std::sqrt(pixel_count);
+    const std::pair<const char*, DrawPair> pair_tests[] = {
+        { "jitter x and y", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 0), g(x, y, 0, 1, 1)); } },
+        { "jitter and first bounce", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 0), g(x, y, 0, 1, 2)); } },
+        { "first and second bounce", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 2), g(x, y, 0, 1, 4)); } },
+        { "pixel and right neighbour", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 0), g(x + 1, y, 0, 1, 0)); } },
+        { "pixel (x, y) and (y, x)", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 0), g(y, x, 0, 1, 0)); } },
+        { "sample and next sample", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 0), g(x, y, 1, 1, 0)); } },
+        { "frame and next frame", [](const Generator& g, int x, int y) { return std::make_pair(g(x, y, 0, 1, 0), g(x, y, 0, 2, 0)); } }
+    };
+
+    bool passed = true;
+    std::printf("%-32s %12s %12s\n", "correlation", "pcg", "sin hash");
+    for (const auto& test : pair_tests) {
+        double pcg = PairCorrelation(PCGDraw, test.second);
+        double sin_hash = PairCorrelation(SinHashDraw, test.second);
+        bool ok = std::abs(pcg) < correlation_limit;
+        std::printf("%-32s %12.5f %12.5f %s\n", test.first, pcg, sin_hash, ok ? "" : "FAIL");
+        passed = passed && ok;
+    }
+    double chi_square = ChiSquare(PCGDraw);
+    bool uniform = chi_square < CHI_SQUARE_LIMIT;
+    std::printf("%-32s %12.2f %12.2f %s\n", "chi-square, 64 bins", chi_square, ChiSquare(SinHashDraw), uniform ? "" : "FAIL");
+    std::printf("limits: |correlation| < %.5f, chi-square < %.1f\n", correlation_limit, CHI_SQUARE_LIMIT);
+    passed = passed && uniform;
+
+    if (check_gpu) {
+        passed = CheckGPU() && passed;
+    }
+    std::cout << (passed ? "Random number tests passed" : "Random number tests failed") << std::endl;
+    return passed;
+}
@@ -0,0 +1,78 @@
+#include <GL/glew.h>
+
+#include <iostream>
+#include <string>
+
+#include "../include/RenderTarget.h"
+
+RenderTargetManager::RenderTargetManager() : live_objects{ 0 } {}
+
+RenderTargetManager::~RenderTargetManager() {
+    ReleaseAll();
+}
+
+const RenderTarget& RenderTargetManager::Acquire(const std::string& name, int width, int height, GLint internal_format) {
+    auto it = targets.find(name);
+    if (it == targets.end()) {
+        RenderTarget target = { 0, 0, width, height, internal_format };
+        glGenFramebuffers(1, &target.fbo);
+        glGenTextures(1, &target.texture);
+        live_objects += 2;
+        Allocate(target);
+        it = targets.emplace(name, target).first;
+    }
+    else if (it->second.width != width || it->second.height != height || it->second.internal_format != internal_format) {
+        // Keep the GL names, only the texture storage has to be respecified
+        it->second.width = width;
+        it->second.height = height;
+        it->second.internal_format = internal_format;
+        Allocate(it->second);
+    }
+    return it->second;
+}
+
+void RenderTargetManager::Release(const std::string& name) {
+    auto it = targets.find(name);
+    if (it != targets.end()) {
+        Free(it->second);
+        targets.erase(it);
+    }
+}
+
+void RenderTargetManager::ReleaseAll() {
+    for (auto& entry : targets) {
+        Free(entry.second);
+    }
+    targets.clear();
+}
+
+void RenderTargetManager::Allocate(RenderTarget& target) {
+    GLenum type = target.internal_format == GL_RGBA8 ? GL_UNSIGNED_BYTE : GL_FLOAT;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, target.internal_format, target.width, target.height, 0, GL_RGBA, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Framebuffer is not complete!" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void RenderTargetManager::Free(RenderTarget& target) {
+    glDeleteFramebuffers(1, &target.fbo);
+    glDeleteTextures(1, &target.texture);
+    target.fbo = 0;
+    target.texture = 0;
+    live_objects -= 2;
+}
+
+//Getters
+int RenderTargetManager::GetLiveObjectCount() const {
+    return live_objects;
+}
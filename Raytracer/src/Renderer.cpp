@@ -10,6 +10,9 @@
 #include <memory>
 #include <chrono>
 #include <random>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -17,22 +20,49 @@
 #include "../include/Renderer.h"
 #include "../include/Shader.h"
 #include "../include/Camera.h"
+#include "../include/Scene.h"
+#include "../include/BlueNoise.h"
 
-#define MAX_OBJECT_COUNT 128
+#define MAX_OBJECT_COUNT 65536
+#define INITIAL_OBJECT_CAPACITY 128
+#define BENCHMARK_MAX_OBJECT_COUNT 16384
 
 Renderer::Renderer(GLFWwindow* window, std::shared_ptr<Camera> camera, int light_bounces, int samples_per_pixel, float resolution_factor, bool show_tooltip)
-    : camera{ nullptr }, light_bounces{ light_bounces }, samples_per_pixel{ samples_per_pixel }, resolution_factor{ resolution_factor }, show_tooltip{show_tooltip},
-    fbo{ 0 }, fbo_texture{ 0 }, scene_updated(true), imgui_initialized(false), play_mode(false) {
-    if (glewInit() != GLEW_OK) {
+    : imgui_initialized(false), fbo{ 0 }, fbo_texture{ 0 }, light_bounces{ light_bounces }, russian_roulette{ true }, roulette_depth{ 3 }, samples_per_pixel{ samples_per_pixel },
+    resolution_factor{ resolution_factor }, show_tooltip{show_tooltip}, run_benchmark{ false }, run_pipeline_benchmark{ false }, pipeline{ RenderPipeline::Fragment }, sort_rays{ false },
+    sampler{ SamplerType::Random }, render_scale{ resolution_factor }, render_samples{ samples_per_pixel }, use_dynamic_resolution{ false }, progressive{ false }, accumulated_samples{ 0 },
+    max_accumulated_samples{ 4096 }, last_look_from{ 0 }, last_look_at{ 0 }, last_vfov{ 0 }, frame_index{ 0 }, tonemapper{ Tonemapper::None }, exposure{ 0.0f }, gamma{ 2.2f }, bvh_refit_count{ 0 },
+    bvh_rebuild_count{ 0 }, count_rays{ false }, sky_horizon{ 1.0f }, sky_zenith{ 0.5f, 0.7f, 1.0f }, scene_buffer{ INITIAL_OBJECT_CAPACITY }, meshes_dirty{ true }, obj_path{}, scene_updated(true),
+    play_mode(false), camera{ nullptr } {
+    // A GLX build of GLEW reports a missing X display on a surfaceless context, the GL entry points are loaded by then
+    GLenum glew_status = glewInit();
+    if (glew_status != GLEW_OK && !(window == nullptr && glew_status == GLEW_ERROR_NO_GLX_DISPLAY)) {
         std::cerr << "Failed to initialize GLEW" << std::endl;
         return;
     }
     font_scale = 1;
     SetupScene();
-    InitImGui(window);
+    // Without a window the renderer is only driven through RenderOffscreen
+    if (window) {
+        InitImGui(window);
+    }
 }
 
 Renderer::~Renderer() {
+    render_targets.ReleaseAll();
+    scene_buffer.Release();
+    wavefront.Release();
+    gpu_timers.clear();
+    for (auto& entry : vao) {
+        glDeleteVertexArrays(1, &entry.second);
+    }
+    for (auto& entry : vbo) {
+        glDeleteBuffers(1, &entry.second);
+    }
+    for (auto& entry : textures) {
+        glDeleteTextures(1, &entry.second);
+    }
+    shaders.clear();
     ShutdownImGui();
 }
 
@@ -41,7 +71,9 @@ void Renderer::SetupScene() {
     SetupTextureAttachment();
     SetupScreenQuad();
     SetupShaders();
-    ApplyPreset1();
+    SetupTimers();
+    SetupBlueNoise();
+    ApplyScene(CreatePreset1());
 }
 
 void Renderer::SetupTextureAttachment() {
@@ -98,90 +130,69 @@ void Renderer::SetupShaders() {
     uniform_locations["camera_center"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_cameraCenter");
     uniform_locations["window_width"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_windowWidth");
     uniform_locations["window_height"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_objects");
-    uniform_locations["objects"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_objects");
     uniform_locations["samples_per_pixel"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_samplesPerPixel");
     uniform_locations["light_bounces"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_lightBounces");
-    uniform_locations["time"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_time");
+    uniform_locations["roulette_depth"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_rouletteDepth");
+    uniform_locations["sky_horizon"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_skyHorizon");
+    uniform_locations["sky_zenith"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_skyZenith");
+    uniform_locations["object_count"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_objectCount");
+    uniform_locations["light_count"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_lightCount");
+    uniform_locations["lights"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_lights");
+    uniform_locations["frame"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_frame");
+    uniform_locations["sample_offset"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_sampleOffset");
+    uniform_locations["blend_weight"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_blendWeight");
+    uniform_locations["count_rays"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_countRays");
+    uniform_locations["sampler"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_sampler");
+    uniform_locations["blue_noise"] = glGetUniformLocation(shaders["ray_tracing"]->GetId(), "u_blueNoise");
 
     shaders["fullscreen_quad"] = std::make_unique<Shader>("shaders/fullscreen_quad.vs.glsl", "shaders/fullscreen_quad.fs.glsl");
     uniform_locations["screen_resolution"] = glGetUniformLocation(shaders["fullscreen_quad"]->GetId(), "screenResolution");
+    uniform_locations["tonemapper"] = glGetUniformLocation(shaders["fullscreen_quad"]->GetId(), "tonemapper");
+    uniform_locations["exposure"] = glGetUniformLocation(shaders["fullscreen_quad"]->GetId(), "exposure");
+    uniform_locations["gamma"] = glGetUniformLocation(shaders["fullscreen_quad"]->GetId(), "gamma");
 }
 
-//-----------Presets----------
-
-void Renderer::ApplyPreset1() {
-    scene_objects.clear();
-    Material material_ground = { MaterialType::Lambertian, glm::vec3(0.8, 0.8, 0.0), 0, 0 };
-    Material material_center = { MaterialType::Lambertian, glm::vec3(0.1, 0.2, 0.5), 0, 0 };
-    Material material_left = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5 };
-    Material material_right = { MaterialType::Metal, glm::vec3(0.8, 0.6, 0.2), 0.2, 0 };
-
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3{0, -100.5, -1}, glm::vec3(100), material_ground });
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3(0.5f), material_center });
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3{-1.0f, 0.0f, -1.0f}, glm::vec3(0.5), material_left });
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3{-1.0f, 0.0f, -1.0f}, glm::vec3(-0.4), material_left });
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3{1.0f, 0.0f, -1.0f}, glm::vec3(0.5f), material_right });
-
-    if (camera) {
-        camera->look_at = glm::vec3{ 0,0,0 };
-        camera->look_from = glm::vec3{ 0,0,1 };
-        camera->vfov = 90;
-    }
-    scene_updated = true;
+void Renderer::SetupTimers() {
+    // Only the ray tracing pass counts its rays
+    gpu_timers["ray_tracing"] = std::make_unique<GPUTimer>(true);
+    gpu_timers["display"] = std::make_unique<GPUTimer>();
+    gpu_timers["imgui"] = std::make_unique<GPUTimer>();
+    last_frame_time = std::chrono::high_resolution_clock::now();
 }
 
-float randomFloat(float min, float max) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> distribution(min, max);  
-
-    return distribution(gen);
+void Renderer::SetupBlueNoise() {
+    // Ranks as integers, the shaders turn them into the top bits of a sample
+    std::vector<uint16_t> ranks = GenerateBlueNoise();
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, BLUE_NOISE_SIZE, BLUE_NOISE_SIZE, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, ranks.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    textures["blue_noise"] = texture;
 }
 
-void Renderer::ApplyPreset2() {
-    scene_objects.clear();
-    Material material_ground = { MaterialType::Lambertian, glm::vec3(0.5, 0.5, 0.5), 0, 0 };
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3{0, -1000, 0}, glm::vec3(1000), material_ground });
-
+//-----------Presets----------
 
-    for (int a = -4; a < 4; a++) {
-        for (int b = -4; b < 4; b++) {
-            auto choose_mat = randomFloat(0, 1);
-            glm::vec3 center(a + 0.9 * randomFloat(0, 1), 0.2, b + 0.9 * randomFloat(0, 1));
+void Renderer::ApplyScene(const Scene& scene) {
+    scene_objects.Clear();
+    for (const Object& object : scene.objects) {
+        scene_objects.Add(object);
+    }
+    meshes = scene.meshes;
+    meshes_dirty = true;
 
-            if ((center - glm::vec3(4, 0.2, 0)).length() > 0.9) {
-                Material sphere_material;
-                if (choose_mat < 0.8) {
-                    // diffuse
-                    glm::vec3 albedo = glm::vec3{ randomFloat(0, 1), randomFloat(0, 1), randomFloat(0, 1) };
-                    sphere_material = { MaterialType::Lambertian, albedo, 0, 0 };
-                    scene_objects.push_back({ ObjectType::Sphere, center, glm::vec3(0.2), sphere_material });
-                }
-                else if (choose_mat < 0.95) {
-                    // metal
-                    glm::vec3 albedo = glm::vec3(randomFloat(0.5f, 1), randomFloat(0.5f, 1), randomFloat(0.5f, 1));
-                    float fuzz = randomFloat(0, 0.5);
-                    sphere_material = { MaterialType::Metal, albedo, fuzz, 0 };
-                    scene_objects.push_back({ ObjectType::Sphere, center, glm::vec3(0.2), sphere_material });
-                }
-                else {
-                    // glass
-                    sphere_material = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5 };
-                    scene_objects.push_back({ ObjectType::Sphere, center, glm::vec3(0.2), sphere_material });
-                }
-            }
-        }
+    if (camera) {
+        camera->look_from = scene.look_from;
+        camera->look_at = scene.look_at;
+        camera->vfov = scene.vfov;
     }
-    Material material1 = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5 };
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3(0, 1, 0), glm::vec3(1), material1});
-    Material material2 = { MaterialType::Lambertian, glm::vec3(0.4, 0.2, 0.1), 0, 0 };
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3(-4, 1, 0), glm::vec3(1), material2 });
-    Material material3 = { MaterialType::Metal, glm::vec3(0.7, 0.6, 0.5), 0, 0 };
-    scene_objects.push_back({ ObjectType::Sphere, glm::vec3(4, 1, 0), glm::vec3(1), material3 });
- 
-    camera->look_from = glm::vec3(13, 2, 3);
-    camera->look_at = glm::vec3(0, 0, 0);
-    camera->vfov = 20;
+    sky_horizon = scene.sky_horizon;
+    sky_zenith = scene.sky_zenith;
+    wavefront.SetSky(sky_horizon, sky_zenith);
     scene_updated = true;
 }
 
@@ -193,6 +204,7 @@ void Renderer::Render(GLFWwindow* window) {
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
+    CollectTimings();
 
     int window_width, window_height;
     glfwGetFramebufferSize(window, &window_width, &window_height);
@@ -201,19 +213,26 @@ void Renderer::Render(GLFWwindow* window) {
     RenderScene(window);
     RenderToolTip(show_tooltip);
     if (play_mode) {
-        scene_updated = true;
+        // Without accumulation every frame traces a fresh image, otherwise only camera movement restarts it
+        scene_updated = !progressive;
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // The Performance window is hidden while playing
+        count_rays = false;
     }
     else {
         scene_updated = false;
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
         RenderSceneSettings();
         RenderCameraSettings();
+        RenderDisplaySettings();
+        RenderPerformance();
         RenderPresetsMenu();
         RenderObjectsUI();
     }
     ImGui::Render();
+    gpu_timers["imgui"]->Begin();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    gpu_timers["imgui"]->End();
 }
 
 //-------------ImGui-------------//
@@ -245,6 +264,14 @@ void Renderer::RenderSceneSettings() {
     if (ImGui::SliderInt("Max Light Bounces", &light_bounces, 1, 128)) {
         scene_updated = true;
     }
+    if (ImGui::Checkbox("Russian roulette", &russian_roulette)) {
+        scene_updated = true;
+    }
+    if (russian_roulette) {
+        if (ImGui::SliderInt("Roulette min depth", &roulette_depth, 1, 16)) {
+            scene_updated = true;
+        }
+    }
 
     if (ImGui::SliderInt("Samples per pixel", &samples_per_pixel, 1, 256)) {
         scene_updated = true;
@@ -254,12 +281,56 @@ void Renderer::RenderSceneSettings() {
         scene_updated = true;
     }
 
+    if (ImGui::Checkbox("Dynamic resolution", &use_dynamic_resolution)) {
+        dynamic_resolution.Reset(resolution_factor, samples_per_pixel);
+        scene_updated = true;
+    }
+    if (use_dynamic_resolution) {
+        ImGui::SliderFloat("Frame budget (ms)", &dynamic_resolution.target_ms, 4.0f, 100.0f);
+        ImGui::SliderFloat("Min resolution scale", &dynamic_resolution.min_scale, 0.1f, 1.0f);
+        ImGui::Checkbox("Adjust samples per pixel", &dynamic_resolution.adjust_samples);
+        ImGui::Text("Rendering at %.2f scale, %d spp", render_scale, render_samples);
+    }
+
+    const char* pipelineNames[] = { "Fragment", "Wavefront" };
+    if (ImGui::Combo("Pipeline", (int*)&pipeline, pipelineNames, IM_ARRAYSIZE(pipelineNames))) {
+        scene_updated = true;
+    }
+    if (pipeline == RenderPipeline::Wavefront) {
+        // Changes the order rays are traced in, not the image
+        ImGui::Checkbox("Sort rays by direction", &sort_rays);
+    }
+    const char* samplerNames[] = { "Random", "Sobol", "Blue noise" };
+    if (ImGui::Combo("Sampler", (int*)&sampler, samplerNames, IM_ARRAYSIZE(samplerNames))) {
+        scene_updated = true;
+    }
+
+    if (ImGui::Checkbox("Progressive", &progressive)) {
+        scene_updated = true;
+    }
+    if (progressive) {
+        ImGui::SliderInt("Max accumulated samples", &max_accumulated_samples, 1, 65536);
+        ImGui::Text("Accumulated samples: %d", accumulated_samples);
+    }
+
     ImGui::Checkbox("Show Tooltip", &show_tooltip);
 
+    ImGui::Text("Live GL objects: %d", GetLiveGLObjectCount());
+
     if (ImGui::Button("Toggle Play Mode")) {
         play_mode = !play_mode;
     }
 
+    if (ImGui::Button("Run Object Count Benchmark")) {
+        run_benchmark = true;
+    }
+    RenderBenchmarkResults();
+
+    if (ImGui::Button("Run Pipeline Benchmark")) {
+        run_pipeline_benchmark = true;
+    }
+    RenderPipelineBenchmarkResults();
+
     ImGui::End();
 }
 
@@ -297,13 +368,67 @@ void Renderer::RenderCameraSettings() {
     ImGui::End();
 }
 
+void Renderer::RenderDisplaySettings() {
+    // Only the display pass changes here, so nothing has to be traced again
+    ImGui::Begin("Display");
+    const char* tonemapperNames[] = { "None", "Reinhard", "ACES" };
+    ImGui::Combo("Tonemapper", (int*)&tonemapper, tonemapperNames, IM_ARRAYSIZE(tonemapperNames));
+    ImGui::SliderFloat("Exposure (EV)", &exposure, -5.0f, 5.0f);
+    ImGui::SliderFloat("Gamma", &gamma, 1.0f, 3.0f);
+    ImGui::End();
+}
+
+void Renderer::RenderPerformance() {
+    // Counting costs every fragment an atomic, so the shader only counts while the counts are on screen
+    count_rays = ImGui::Begin("Performance");
+    const std::pair<const char*, const char*> passes[] = {
+        { "frame", "Frame (CPU)" },
+        { "ray_tracing", "Ray tracing" },
+        { "display", "Display" },
+        { "imgui", "ImGui" }
+    };
+    ImGui::Text("%-12s %8s %8s %8s", "ms", "min", "avg", "p99");
+    for (const auto& pass : passes) {
+        const FrameStats& stats = frame_stats[pass.first];
+        ImGui::Text("%-12s %8.2f %8.2f %8.2f", pass.second, stats.GetMin(), stats.GetAverage(), stats.GetPercentile(99.0f));
+    }
+    // The average path length, what a pass costs once russian roulette ends paths before the bounce limit
+    ImGui::Text("Rays per sample: %.2f", frame_stats["rays_per_sample"].GetAverage());
+    // Times of the recent ones, a refit should be a small fraction of a rebuild
+    ImGui::Text("BVH refits: %d, %.3f ms avg", bvh_refit_count, frame_stats["bvh_refit"].GetAverage());
+    ImGui::Text("BVH rebuilds: %d, %.3f ms avg", bvh_rebuild_count, frame_stats["bvh_rebuild"].GetAverage());
+    ImGui::Text("BVH SAH cost: %.2f, growth since built: %.2f", bvh.GetCost(), bvh.GetGrowth());
+
+    // Frames that do not trace anything leave the ray and sample rates unchanged
+    const std::pair<const char*, const char*> plots[] = {
+        { "frame", "Frame time (ms)" },
+        { "rays_per_second", "Rays/s (M)" },
+        { "samples_per_second", "Samples/s (M)" }
+    };
+    for (const auto& plot : plots) {
+        const FrameStats& stats = frame_stats[plot.first];
+        std::string overlay = std::to_string(stats.GetLatest());
+        ImGui::PlotLines(plot.second, stats.GetHistory(), stats.GetCount(), stats.GetOffset(), overlay.c_str(), 0.0f, FLT_MAX, ImVec2(0, 60));
+    }
+    ImGui::End();
+}
+
 void Renderer::RenderPresetsMenu() {
     ImGui::Begin("Presets");
     if (ImGui::Button("Preset 1")) {
-        ApplyPreset1();
+        ApplyScene(CreatePreset1());
     }
     if (ImGui::Button("Preset 2")) {
-        ApplyPreset2();
+        ApplyScene(CreatePreset2());
+    }
+    if (ImGui::Button("Furnace")) {
+        ApplyScene(CreateFurnaceScene());
+    }
+    if (ImGui::Button("Lights")) {
+        ApplyScene(CreateLightsPreset());
+    }
+    if (ImGui::Button("Instances")) {
+        ApplyScene(CreateInstancesPreset());
     }
     ImGui::End();
 }
@@ -311,7 +436,7 @@ void Renderer::RenderPresetsMenu() {
 void Renderer::RenderObjectsUI() {
     ImGui::Begin("Objects");
 
-    for (size_t i = 0; i < scene_objects.size(); ++i) {
+    for (size_t i = 0; i < scene_objects.Size(); ++i) {
         std::string objectName = "Object " + std::to_string(i);
 
         if (ImGui::TreeNode(objectName.c_str())) {
@@ -319,7 +444,7 @@ void Renderer::RenderObjectsUI() {
 
             // Edit object type
             ImGui::Text("Type:");
-            const char* objectTypeNames[] = { "None", "Sphere" };
+            const char* objectTypeNames[] = { "None", "Sphere", "Quad", "Mesh" };
             if (ImGui::Combo(("##Type" + std::to_string(i)).c_str(), (int*)&scene_objects[i].type, objectTypeNames, IM_ARRAYSIZE(objectTypeNames))) {
                 isObjectModified = true;
             }
@@ -338,13 +463,45 @@ void Renderer::RenderObjectsUI() {
                     isObjectModified = true;
                 }
                 break;
+            case ObjectType::Quad:
+                // The axis left at 0 is the one the quad faces
+                ImGui::Text("Half Size:");
+                if (ImGui::SliderFloat3(("##HalfSize" + std::to_string(i)).c_str(), glm::value_ptr(scene_objects[i].scale), 0.0f, 10.0f)) {
+                    isObjectModified = true;
+                }
+                break;
+            case ObjectType::Mesh: {
+                // Any of the loaded meshes, placed with a scale per axis and a rotation
+                ImGui::Text("Mesh:");
+                int mesh = scene_objects[i].mesh;
+                const char* preview = mesh >= 0 && mesh < static_cast<int>(meshes.size()) ? meshes[mesh]->name.c_str() : "None";
+                if (ImGui::BeginCombo(("##Mesh" + std::to_string(i)).c_str(), preview)) {
+                    for (size_t m = 0; m < meshes.size(); ++m) {
+                        std::string label = meshes[m]->name + " (" + std::to_string(meshes[m]->triangles.size()) + " triangles)##" + std::to_string(m);
+                        if (ImGui::Selectable(label.c_str(), mesh == static_cast<int>(m))) {
+                            scene_objects[i].mesh = static_cast<int>(m);
+                            isObjectModified = true;
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+                ImGui::Text("Scale:");
+                if (ImGui::SliderFloat3(("##MeshScale" + std::to_string(i)).c_str(), glm::value_ptr(scene_objects[i].scale), 0.01f, 10.0f)) {
+                    isObjectModified = true;
+                }
+                ImGui::Text("Rotation:");
+                if (ImGui::SliderFloat3(("##MeshRotation" + std::to_string(i)).c_str(), glm::value_ptr(scene_objects[i].rotation), -180.0f, 180.0f)) {
+                    isObjectModified = true;
+                }
+                break;
+            }
             default:
                 break;
             }
 
             // Edit material type
             ImGui::Text("Material Type:");
-            const char* materialTypeNames[] = { "None", "Lambertian", "Metal", "Dielectric" };
+            const char* materialTypeNames[] = { "None", "Lambertian", "Metal", "Dielectric", "Emissive" };
             if (ImGui::Combo(("##MaterialType" + std::to_string(i)).c_str(), (int*)&scene_objects[i].material.type, materialTypeNames, IM_ARRAYSIZE(materialTypeNames))) {
                 isObjectModified = true;
             }
@@ -375,6 +532,13 @@ void Renderer::RenderObjectsUI() {
                 }
                 break;
 
+            case MaterialType::Emissive:
+                ImGui::Text("Radiance:");
+                if (ImGui::ColorEdit3(("##Radiance" + std::to_string(i)).c_str(), glm::value_ptr(scene_objects[i].material.albedo), ImGuiColorEditFlags_HDR | ImGuiColorEditFlags_Float)) {
+                    isObjectModified = true;
+                }
+                break;
+
             default:
                 break;
             }
@@ -389,9 +553,14 @@ void Renderer::RenderObjectsUI() {
                 break;
             }
 
+            // Record the edit so only this object is uploaded again
+            if (isObjectModified) {
+                scene_objects.MarkDirty(i);
+            }
+
             // Button to remove the object
             if (ImGui::Button(("Remove##" + std::to_string(i)).c_str())) {
-                scene_objects.erase(scene_objects.begin() + i);
+                scene_objects.Remove(i);
                 isObjectModified = true;
                 --i; // Adjust index after removal
             }
@@ -407,8 +576,24 @@ void Renderer::RenderObjectsUI() {
 
     // Add button to add a new object
     if (ImGui::Button("Add Object")) {
-        if (scene_objects.size() < MAX_OBJECT_COUNT) {
-            scene_objects.push_back(Object());
+        if (scene_objects.Size() < MAX_OBJECT_COUNT) {
+            scene_objects.Add(Object());
+            scene_updated = true;
+        }
+    }
+
+    // Loads a mesh and places it at the origin, other objects can then pick it too
+    ImGui::InputText("##ObjPath", obj_path, sizeof(obj_path));
+    ImGui::SameLine();
+    if (ImGui::Button("Load OBJ") && scene_objects.Size() < MAX_OBJECT_COUNT) {
+        auto mesh = std::make_shared<Mesh>();
+        if (LoadOBJ(obj_path, *mesh)) {
+            Material material = { MaterialType::Lambertian, glm::vec3(0.5f), 0, 0 };
+            Object object = { ObjectType::Mesh, glm::vec3(0.0f), glm::vec3(1.0f), material };
+            object.mesh = static_cast<int>(meshes.size());
+            meshes.push_back(mesh);
+            meshes_dirty = true;
+            scene_objects.Add(object);
             scene_updated = true;
         }
     }
@@ -457,8 +642,44 @@ void Renderer::RenderScene(GLFWwindow* window) {
     glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
     float window_width = static_cast<float>(framebuffer_width);
     float window_height = static_cast<float>(framebuffer_height);
+
+    if (run_benchmark) {
+        RunObjectCountBenchmark(window_width, window_height);
+        run_benchmark = false;
+    }
+    if (run_pipeline_benchmark) {
+        RunPipelineBenchmark(window_width, window_height);
+        run_pipeline_benchmark = false;
+    }
     
-    if (scene_updated) {
+    bool camera_moved = CameraMoved();
+    if (camera_moved) {
+        scene_updated = true;
+    }
+
+    render_scale = resolution_factor;
+    render_samples = samples_per_pixel;
+    if (use_dynamic_resolution) {
+        // Lowered while the camera moves and back to full once it stops, either way the image is traced again
+        if (dynamic_resolution.Update(camera_moved, resolution_factor, samples_per_pixel, window_width, window_height)) {
+            scene_updated = true;
+        }
+        render_scale = dynamic_resolution.GetScale(resolution_factor);
+        render_samples = dynamic_resolution.GetSamples(samples_per_pixel);
+    }
+
+    if (progressive) {
+        // Keep adding samples to the accumulation target until something changes
+        if (scene_updated) {
+            ResetAccumulation();
+        }
+        if (accumulated_samples < max_accumulated_samples) {
+            UpdateTexture(window_width, window_height);
+        }
+    }
+    else if (scene_updated) {
+        // A new image gets new random numbers, otherwise a still camera would show the same noise every frame
+        ++frame_index;
         UpdateTexture(window_width, window_height);
     }
     //UpdateTexture(window_width, window_height);
@@ -467,40 +688,58 @@ void Renderer::RenderScene(GLFWwindow* window) {
 
 void Renderer::UpdateTexture(int window_width, int window_height) {
     // Set up FBO with lower resolution
-    int lower_resolution_width = window_width * resolution_factor; // Set your desired lower resolution width
-    int lower_resolution_height = window_height * resolution_factor; // Set your desired lower resolution height
+    int lower_resolution_width = window_width * render_scale; // Set your desired lower resolution width
+    int lower_resolution_height = window_height * render_scale; // Set your desired lower resolution height
     UpdateFBO(lower_resolution_width, lower_resolution_height);
 
     // Render to texture in FBO 
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     glViewport(0, 0, lower_resolution_width, lower_resolution_height);
-    SendUniforms(lower_resolution_width, lower_resolution_height);
-    RenderObjects();
+    if (progressive) {
+        if (accumulated_samples == 0) {
+            const GLfloat clear_color[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 0, clear_color);
+        }
+        // The shader writes the weight of the new samples in alpha: new * w + old * (1 - w)
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ZERO);
+    }
+    glActiveTexture(GL_TEXTURE0 + BLUE_NOISE_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, textures["blue_noise"]);
+    glActiveTexture(GL_TEXTURE0);
+    gpu_timers["ray_tracing"]->Begin(static_cast<long long>(lower_resolution_width) * lower_resolution_height * render_samples);
+    if (pipeline == RenderPipeline::Wavefront) {
+        TraceWavefront(lower_resolution_width, lower_resolution_height);
+    }
+    else {
+        SendUniforms(lower_resolution_width, lower_resolution_height);
+        RenderObjects();
+    }
+    gpu_timers["ray_tracing"]->End();
+    glDisable(GL_BLEND);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (progressive) {
+        accumulated_samples += render_samples;
+    }
 }
 
 void Renderer::RenderTexture(int window_width, int window_height) {
     glViewport(0, 0, window_width, window_height);
+    gpu_timers["display"]->Begin();
     SendQuadUniforms(window_width, window_height);
     RenderScreenQuad(fbo_texture);
+    gpu_timers["display"]->End();
 }
 
 void Renderer::UpdateFBO(int width, int height) {
-    glGenFramebuffers(1, &fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
-    glGenTextures(1, &fbo_texture);
-    glBindTexture(GL_TEXTURE_2D, fbo_texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fbo_texture, 0);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        std::cerr << "Framebuffer is not complete!" << std::endl;
-    }
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // Reuses the existing target unless the resolution changed
+    // Linear HDR radiance, tonemapping and gamma are applied when displayed.
+    // Accumulating many frames needs full float precision, a single frame fits in half floats
+    GLint internal_format = progressive ? GL_RGBA32F : GL_RGBA16F;
+    const RenderTarget& target = render_targets.Acquire("ray_tracing", width, height, internal_format);
+    fbo = target.fbo;
+    fbo_texture = target.texture;
 }
 
 void Renderer::SendUniforms(float window_width, float window_height) {
@@ -511,41 +750,82 @@ void Renderer::SendUniforms(float window_width, float window_height) {
     glUniform3fv(uniform_locations["pixel_delta_u"], 1, glm::value_ptr(camera->pixel_delta_u));
     glUniform3fv(uniform_locations["pixel_delta_v"], 1, glm::value_ptr(camera->pixel_delta_v));
 
-    glUniform1i(uniform_locations["samples_per_pixel"], samples_per_pixel);
+    glUniform1i(uniform_locations["samples_per_pixel"], render_samples);
     glUniform1i(uniform_locations["light_bounces"], light_bounces);
-    auto current_time_point = std::chrono::high_resolution_clock::now();
-    auto duration_since_epoch = current_time_point.time_since_epoch();
-    float current_time_in_seconds = std::chrono::duration_cast<std::chrono::milliseconds>(duration_since_epoch).count() / 1000.0f;
-    glUniform1f(uniform_locations["time"], current_time_in_seconds);
+    glUniform1i(uniform_locations["count_rays"], count_rays);
+    glUniform1i(uniform_locations["roulette_depth"], russian_roulette ? roulette_depth : -1);
+    glUniform3fv(uniform_locations["sky_horizon"], 1, glm::value_ptr(sky_horizon));
+    glUniform3fv(uniform_locations["sky_zenith"], 1, glm::value_ptr(sky_zenith));
+    glUniform1ui(uniform_locations["frame"], frame_index);
+    glUniform1i(uniform_locations["sampler"], static_cast<int>(sampler));
+    glUniform1i(uniform_locations["blue_noise"], BLUE_NOISE_TEXTURE_UNIT);
+
+    // Accumulated frames continue the sample sequence instead of repeating it
+    int sample_offset = progressive ? accumulated_samples : 0;
+    float blend_weight = static_cast<float>(render_samples) / (sample_offset + render_samples);
+    glUniform1i(uniform_locations["sample_offset"], sample_offset);
+    glUniform1f(uniform_locations["blend_weight"], blend_weight);
 }
 
-void Renderer::RenderObjects() {
-    // Objects
-    for (size_t i = 0; i < scene_objects.size(); ++i) {
-        std::string objectIndex = std::to_string(i);
-        // Send type
-        glUniform1i(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].type").c_str()), static_cast<int>(scene_objects[i].type));
-        // Send position
-        glUniform3fv(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].position").c_str()), 1, glm::value_ptr(scene_objects[i].position));
-        // Send scale
-        glUniform3fv(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].scale").c_str()), 1, glm::value_ptr(scene_objects[i].scale));
-        // Send material type
-        glUniform1i(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].material.type").c_str()), static_cast<int>(scene_objects[i].material.type));
-        // Send material albedo
-        glUniform3fv(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].material.albedo").c_str()), 1, glm::value_ptr(scene_objects[i].material.albedo));
-        // Send metal fuzziness
-        glUniform1f(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].material.fuzz").c_str()), scene_objects[i].material.fuzz);
-        // Send refraction index
-        glUniform1f(glGetUniformLocation(shaders["ray_tracing"]->GetId(), ("u_objects[" + objectIndex + "].material.refraction_index").c_str()), scene_objects[i].material.refraction_index);
+void Renderer::UploadScene() {
+    // New meshes move the others in the mesh textures, so every object is packed again
+    if (meshes_dirty) {
+        scene_buffer.UploadMeshes(meshes);
+        scene_objects.MarkDirty(0, scene_objects.Size());
+        meshes_dirty = false;
+    }
+    // Only the objects changed since the last frame are repacked and uploaded. The BVH is the top level: moving, turning
+    // or recolouring a mesh object only touches its own entry, the mesh BVHs stay as they are
+    if (scene_objects.IsDirty()) {
+        // Moved objects only stretch the nodes above them, until that makes the tree too slow to trace
+        auto start = std::chrono::high_resolution_clock::now();
+        bool refitted = bvh.Refit(scene_objects.GetObjects(), meshes, scene_objects.GetDirtyRanges());
+        if (!refitted) {
+            bvh.Build(scene_objects.GetObjects(), meshes);
+        }
+        float bvh_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        frame_stats[refitted ? "bvh_refit" : "bvh_rebuild"].Add(bvh_ms);
+        ++(refitted ? bvh_refit_count : bvh_rebuild_count);
+        lights = FindLights(scene_objects.GetObjects());
+        wavefront.SetLights(lights);
+        scene_buffer.Upload(scene_objects);
+        scene_buffer.UploadBVH(bvh);
+        scene_objects.ClearDirty();
     }
+    scene_buffer.Bind();
+}
+
+void Renderer::RenderObjects() {
+    UploadScene();
+    // Objects the BVH skipped (null objects) are not counted
+    glUniform1i(uniform_locations["object_count"], static_cast<int>(bvh.GetPrimitiveIndices().size()));
+    glUniform1i(uniform_locations["light_count"], static_cast<int>(lights.size()));
+    glUniform1iv(uniform_locations["lights"], static_cast<GLsizei>(lights.size()), lights.data());
+
     glBindVertexArray(vao["ray_tracing"]);
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
 }
 
+void Renderer::TraceWavefront(int width, int height) {
+    camera->UpdateWindow(width, height);
+    UploadScene();
+
+    // Same sample sequence and accumulation weight as the fragment path, so the two can be swapped mid accumulation
+    int sample_offset = progressive ? accumulated_samples : 0;
+    float blend_weight = static_cast<float>(render_samples) / (sample_offset + render_samples);
+    int object_count = static_cast<int>(bvh.GetPrimitiveIndices().size());
+    wavefront.SetRaySorting(sort_rays);
+    wavefront.Trace(*camera, width, height, render_samples, sample_offset, frame_index, light_bounces, russian_roulette ? roulette_depth : -1, object_count, sampler);
+    wavefront.Resolve(width, render_samples, blend_weight, vao["ray_tracing"]);
+}
+
 void Renderer::SendQuadUniforms(float window_width, float window_height) {
     shaders["fullscreen_quad"]->Use();
     glUniform2f(uniform_locations["screen_resolution"], window_width, window_height);
+    glUniform1i(uniform_locations["tonemapper"], static_cast<int>(tonemapper));
+    glUniform1f(uniform_locations["exposure"], exposure);
+    glUniform1f(uniform_locations["gamma"], gamma);
 }
 
 void Renderer::RenderScreenQuad(GLuint texture) {
@@ -554,4 +834,280 @@ void Renderer::RenderScreenQuad(GLuint texture) {
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
     glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool Renderer::CameraMoved() {
+    if (!camera) {
+        return false;
+    }
+    bool moved = camera->look_from != last_look_from || camera->look_at != last_look_at || camera->vfov != last_vfov;
+    last_look_from = camera->look_from;
+    last_look_at = camera->look_at;
+    last_vfov = camera->vfov;
+    return moved;
+}
+
+void Renderer::ResetAccumulation() {
+    accumulated_samples = 0;
+    ++frame_index;
+}
+
+//-----------Profiling-------------
+
+void Renderer::CollectTimings() {
+    auto now = std::chrono::high_resolution_clock::now();
+    frame_stats["frame"].Add(std::chrono::duration<float, std::milli>(now - last_frame_time).count());
+    last_frame_time = now;
+
+    GPUTimerResult result;
+    while (gpu_timers["ray_tracing"]->Collect(result)) {
+        frame_stats["ray_tracing"].Add(static_cast<float>(result.milliseconds));
+        dynamic_resolution.AddMeasurement(result.milliseconds, result.samples);
+        if (result.milliseconds > 0) {
+            // Nothing is counted while the Performance window is closed, see count_rays
+            if (result.rays > 0) {
+                frame_stats["rays_per_second"].Add(static_cast<float>(result.rays / (result.milliseconds * 1e3)));
+            }
+            frame_stats["samples_per_second"].Add(static_cast<float>(result.samples / (result.milliseconds * 1e3)));
+        }
+        if (result.samples > 0 && result.rays > 0) {
+            frame_stats["rays_per_sample"].Add(static_cast<float>(static_cast<double>(result.rays) / result.samples));
+        }
+    }
+    while (gpu_timers["display"]->Collect(result)) {
+        frame_stats["display"].Add(static_cast<float>(result.milliseconds));
+    }
+    while (gpu_timers["imgui"]->Collect(result)) {
+        frame_stats["imgui"].Add(static_cast<float>(result.milliseconds));
+    }
+}
+
+//-----------Offscreen Rendering-------------
+
+void Renderer::RenderOffscreen(int width, int height, int total_samples, unsigned int frame) {
+    // Accumulate in passes of at most samples_per_pixel so a single draw never runs long enough to trip a GPU watchdog
+    bool saved_progressive = progressive;
+    progressive = true;
+    render_scale = 1.0f;
+    ResetAccumulation();
+    // Reproducible, and the same samples as CPURenderer::Render with the same frame
+    frame_index = frame;
+    while (accumulated_samples < total_samples) {
+        render_samples = std::min(samples_per_pixel, total_samples - accumulated_samples);
+        UpdateTexture(width, height);
+        glFinish();
+    }
+    progressive = saved_progressive;
+
+    // Run the display pass into an 8 bit target instead of the window
+    const RenderTarget& display = render_targets.Acquire("display", width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, display.fbo);
+    RenderTexture(width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+std::vector<unsigned char> Renderer::ReadPixels(int width, int height) {
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 3);
+    glBindFramebuffer(GL_FRAMEBUFFER, render_targets.Acquire("display", width, height).fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    FlipRows(pixels.data(), width * 3 * sizeof(unsigned char), height);
+    return pixels;
+}
+
+std::vector<float> Renderer::ReadRadiance(int width, int height) {
+    std::vector<float> pixels(static_cast<size_t>(width) * height * 3);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_FLOAT, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    FlipRows(pixels.data(), width * 3 * sizeof(float), height);
+    return pixels;
+}
+
+void Renderer::ReadRayCoherence(unsigned long long& rays, unsigned long long& coherent_rays) {
+    wavefront.ReadCoherence(rays, coherent_rays);
+}
+
+void Renderer::FlipRows(void* pixels, size_t row_size, int height) {
+    // OpenGL returns the bottom row first
+    std::vector<unsigned char> row(row_size);
+    unsigned char* bytes = static_cast<unsigned char*>(pixels);
+    for (int y = 0; y < height / 2; ++y) {
+        unsigned char* top = bytes + y * row_size;
+        unsigned char* bottom = bytes + (height - 1 - y) * row_size;
+        std::copy(top, top + row_size, row.begin());
+        std::copy(bottom, bottom + row_size, top);
+        std::copy(row.begin(), row.end(), bottom);
+    }
+}
+
+void Renderer::SetDisplaySettings(Tonemapper display_tonemapper, float display_exposure, float display_gamma) {
+    tonemapper = display_tonemapper;
+    exposure = display_exposure;
+    gamma = display_gamma;
+}
+
+void Renderer::SetPipeline(RenderPipeline render_pipeline) {
+    pipeline = render_pipeline;
+    scene_updated = true;
+}
+
+void Renderer::SetRaySorting(bool sort) {
+    sort_rays = sort;
+}
+
+void Renderer::SetCoherenceCounting(bool count) {
+    wavefront.SetCoherenceCounting(count);
+}
+
+void Renderer::SetRussianRoulette(int min_depth) {
+    russian_roulette = min_depth >= 0;
+    if (russian_roulette) {
+        roulette_depth = min_depth;
+    }
+    scene_updated = true;
+}
+
+void Renderer::SetSampler(SamplerType render_sampler) {
+    sampler = render_sampler;
+    scene_updated = true;
+}
+
+//-----------Benchmarks-------------
+
+void Renderer::RunObjectCountBenchmark(int window_width, int window_height) {
+    const int frames_per_count = 8;
+    render_scale = resolution_factor;
+    render_samples = samples_per_pixel;
+    int width = window_width * render_scale;
+    int height = window_height * render_scale;
+
+    // Benchmark on a throwaway scene and put the user's scene back afterwards
+    SceneObjects saved_objects = scene_objects;
+    bool saved_progressive = progressive;
+    progressive = false;
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<float> distribution(-4.0f, 4.0f);
+    Material material = { MaterialType::Lambertian, glm::vec3(0.5f), 0, 0 };
+
+    object_count_benchmark.clear();
+    for (int count = 1; count <= BENCHMARK_MAX_OBJECT_COUNT; count *= 2) {
+        // Spheres shrink as their number grows so the box does not fill up
+        float radius = std::min(0.25f, 1.0f / std::cbrt(static_cast<float>(count)));
+        scene_objects.Clear();
+        for (int i = 0; i < count; ++i) {
+            glm::vec3 position(distribution(gen), distribution(gen), distribution(gen) - 5.0f);
+            scene_objects.Add({ ObjectType::Sphere, position, glm::vec3(radius), material });
+        }
+
+        // Warm up once so the upload is not part of the measurement
+        UpdateTexture(window_width, window_height);
+        glFinish();
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < frames_per_count; ++frame) {
+            UpdateTexture(window_width, window_height);
+        }
+        glFinish();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double frame_ms = std::chrono::duration<double, std::milli>(end - start).count() / frames_per_count;
+        object_count_benchmark.push_back({ count, frame_ms });
+        std::cout << "objects: " << count << " (" << width << "x" << height << ", " << samples_per_pixel << " spp) " << frame_ms << " ms/frame" << std::endl;
+    }
+
+    scene_objects = saved_objects;
+    scene_objects.MarkDirty(0, scene_objects.Size());
+    progressive = saved_progressive;
+    scene_updated = true;
+}
+
+void Renderer::RunPipelineBenchmark(int window_width, int window_height) {
+    const int frames_per_pipeline = 8;
+    render_scale = resolution_factor;
+    render_samples = samples_per_pixel;
+    int width = window_width * render_scale;
+    int height = window_height * render_scale;
+
+    // Benchmark on the presets and put the user's scene, camera and pipeline back afterwards
+    SceneObjects saved_objects = scene_objects;
+    std::vector<std::shared_ptr<const Mesh>> saved_meshes = meshes;
+    glm::vec3 saved_look_from = camera->look_from;
+    glm::vec3 saved_look_at = camera->look_at;
+    float saved_vfov = camera->vfov;
+    bool saved_progressive = progressive;
+    RenderPipeline saved_pipeline = pipeline;
+    progressive = false;
+    // A fixed seed so the second preset is the same scene on every run
+    const std::pair<const char*, Scene> scenes[] = {
+        { "Preset 1", CreatePreset1() },
+        { "Preset 2", CreatePreset2(1) }
+    };
+
+    pipeline_benchmark.clear();
+    for (const auto& scene : scenes) {
+        ApplyScene(scene.second);
+        double frame_ms[2];
+        for (int i = 0; i < 2; ++i) {
+            pipeline = i == 0 ? RenderPipeline::Fragment : RenderPipeline::Wavefront;
+            // Warm up once so the upload and the wavefront buffers are not part of the measurement
+            UpdateTexture(window_width, window_height);
+            glFinish();
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int frame = 0; frame < frames_per_pipeline; ++frame) {
+                UpdateTexture(window_width, window_height);
+            }
+            glFinish();
+            auto end = std::chrono::high_resolution_clock::now();
+            frame_ms[i] = std::chrono::duration<double, std::milli>(end - start).count() / frames_per_pipeline;
+        }
+        pipeline_benchmark.push_back({ scene.first, frame_ms[0], frame_ms[1] });
+        std::cout << scene.first << " (" << scene.second.objects.size() << " objects, " << width << "x" << height << ", " << samples_per_pixel << " spp, " << light_bounces << " bounces) "
+            << "fragment " << frame_ms[0] << " ms/frame, wavefront " << frame_ms[1] << " ms/frame" << std::endl;
+    }
+
+    scene_objects = saved_objects;
+    meshes = saved_meshes;
+    meshes_dirty = true;
+    scene_objects.MarkDirty(0, scene_objects.Size());
+    camera->look_from = saved_look_from;
+    camera->look_at = saved_look_at;
+    camera->vfov = saved_vfov;
+    progressive = saved_progressive;
+    pipeline = saved_pipeline;
+    scene_updated = true;
+}
+
+void Renderer::RenderBenchmarkResults() {
+    if (object_count_benchmark.empty()) {
+        return;
+    }
+    ImGui::Text("Objects    ms/frame");
+    for (const auto& result : object_count_benchmark) {
+        ImGui::Text("%7d    %8.2f", result.first, result.second);
+    }
+}
+
+void Renderer::RenderPipelineBenchmarkResults() {
+    if (pipeline_benchmark.empty()) {
+        return;
+    }
+    ImGui::Text("Scene       Fragment   Wavefront  (ms/frame)");
+    for (const auto& result : pipeline_benchmark) {
+        ImGui::Text("%-10s  %8.2f   %9.2f", std::get<0>(result).c_str(), std::get<1>(result), std::get<2>(result));
+    }
+}
+
+//-----------Getters-------------
+
+int Renderer::GetLiveGLObjectCount() const {
+    int count = render_targets.GetLiveObjectCount();
+    count += static_cast<int>(vao.size() + vbo.size() + textures.size());
+    count += scene_buffer.GetLiveObjectCount();
+    count += wavefront.GetLiveObjectCount();
+    for (const auto& entry : gpu_timers) {
+        count += entry.second->GetLiveObjectCount();
+    }
+    return count;
 }
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "../include/Scene.h"
+
+Scene CreatePreset1() {
+    Scene scene;
+    Material material_ground = { MaterialType::Lambertian, glm::vec3(0.8, 0.8, 0.0), 0, 0 };
+    Material material_center = { MaterialType::Lambertian, glm::vec3(0.1, 0.2, 0.5), 0, 0 };
+    Material material_left = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5 };
+    Material material_right = { MaterialType::Metal, glm::vec3(0.8, 0.6, 0.2), 0.2, 0 };
+
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{0, -100.5, -1}, glm::vec3(100), material_ground });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{0.0f, 0.0f, -1.0f}, glm::vec3(0.5f), material_center });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{-1.0f, 0.0f, -1.0f}, glm::vec3(0.5), material_left });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{-1.0f, 0.0f, -1.0f}, glm::vec3(-0.4), material_left });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{1.0f, 0.0f, -1.0f}, glm::vec3(0.5f), material_right });
+
+    scene.look_at = glm::vec3{ 0,0,0 };
+    scene.look_from = glm::vec3{ 0,0,1 };
+    scene.vfov = 90;
+    return scene;
+}
+
+static float randomFloat(std::mt19937& gen, float min, float max) {
+    std::uniform_real_distribution<float> distribution(min, max);
+
+    return distribution(gen);
+}
+
+Scene CreatePreset2(unsigned int seed) {
+    // Seeded so an offline render can be repeated exactly
+    std::mt19937 gen(seed);
+    Scene scene;
+    Material material_ground = { MaterialType::Lambertian, glm::vec3(0.5, 0.5, 0.5), 0, 0 };
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{0, -1000, 0}, glm::vec3(1000), material_ground });
+
+
+    for (int a = -4; a < 4; a++) {
+        for (int b = -4; b < 4; b++) {
+            auto choose_mat = randomFloat(gen, 0, 1);
+            glm::vec3 center(a + 0.9 * randomFloat(gen, 0, 1), 0.2, b + 0.9 * randomFloat(gen, 0, 1));
+
+            if ((center - glm::vec3(4, 0.2, 0)).length() > 0.9) {
+                Material sphere_material;
+                if (choose_mat < 0.8) {
+                    // diffuse
+                    glm::vec3 albedo = glm::vec3{ randomFloat(gen, 0, 1), randomFloat(gen, 0, 1), randomFloat(gen, 0, 1) };
+                    sphere_material = { MaterialType::Lambertian, albedo, 0, 0 };
+                    scene.objects.push_back({ ObjectType::Sphere, center, glm::vec3(0.2), sphere_material });
+                }
+                else if (choose_mat < 0.95) {
+                    // metal
+                    glm::vec3 albedo = glm::vec3(randomFloat(gen, 0.5f, 1), randomFloat(gen, 0.5f, 1), randomFloat(gen, 0.5f, 1));
+                    float fuzz = randomFloat(gen, 0, 0.5);
+                    sphere_material = { MaterialType::Metal, albedo, fuzz, 0 };
+                    scene.objects.push_back({ ObjectType::Sphere, center, glm::vec3(0.2), sphere_material });
+                }
+                else {
+                    // glass
+                    sphere_material = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5 };
+                    scene.objects.push_back({ ObjectType::Sphere, center, glm::vec3(0.2), sphere_material });
+                }
+            }
+        }
+    }
+    Material material1 = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5 };
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(0, 1, 0), glm::vec3(1), material1});
+    Material material2 = { MaterialType::Lambertian, glm::vec3(0.4, 0.2, 0.1), 0, 0 };
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(-4, 1, 0), glm::vec3(1), material2 });
+    Material material3 = { MaterialType::Metal, glm::vec3(0.7, 0.6, 0.5), 0, 0 };
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(4, 1, 0), glm::vec3(1), material3 });
+
+    scene.look_from = glm::vec3(13, 2, 3);
+    scene.look_at = glm::vec3(0, 0, 0);
+    scene.vfov = 20;
+    return scene;
+}
+
+Scene CreateFurnaceScene(float albedo) {
+    Scene scene;
+    Material material = { MaterialType::Lambertian, glm::vec3(albedo), 0, 0 };
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(0), glm::vec3(1), material });
+
+    // The sphere subtends 19.5 degrees from here, wider than the view at any aspect ratio up to 1.9
+    scene.look_from = glm::vec3(0, 0, 3);
+    scene.look_at = glm::vec3(0, 0, 0);
+    scene.vfov = 20;
+    scene.sky_horizon = glm::vec3(1);
+    scene.sky_zenith = glm::vec3(1);
+    return scene;
+}
+
+Scene CreateLightsPreset() {
+    Scene scene;
+    Material white = { MaterialType::Lambertian, glm::vec3(0.73f), 0, 0 };
+    Material red = { MaterialType::Lambertian, glm::vec3(0.65f, 0.05f, 0.05f), 0, 0 };
+    Material green = { MaterialType::Lambertian, glm::vec3(0.12f, 0.45f, 0.15f), 0, 0 };
+    Material metal = { MaterialType::Metal, glm::vec3(0.8f, 0.85f, 0.88f), 0.05f, 0 };
+    Material glass = { MaterialType::Dielectric, glm::vec3(0), 0, 1.5f };
+
+    // Walls of a 2 x 2 x 2 box open towards the camera
+    scene.objects.push_back({ ObjectType::Quad, glm::vec3(0, -1, 0), glm::vec3(1, 0, 1), white });
+    scene.objects.push_back({ ObjectType::Quad, glm::vec3(0, 1, 0), glm::vec3(1, 0, 1), white });
+    scene.objects.push_back({ ObjectType::Quad, glm::vec3(0, 0, -1), glm::vec3(1, 1, 0), white });
+    scene.objects.push_back({ ObjectType::Quad, glm::vec3(-1, 0, 0), glm::vec3(0, 1, 1), red });
+    scene.objects.push_back({ ObjectType::Quad, glm::vec3(1, 0, 0), glm::vec3(0, 1, 1), green });
+
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(-0.4f, -0.6f, -0.3f), glm::vec3(0.4f), metal });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(0.45f, -0.65f, 0.2f), glm::vec3(0.35f), glass });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(0.3f, -0.2f, -0.7f), glm::vec3(0.25f), white });
+
+    // Just below the ceiling so the quad is not inside it, and a sphere far smaller than the scene
+    Material ceiling_light = { MaterialType::Emissive, glm::vec3(15.0f), 0, 0 };
+    Material sphere_light = { MaterialType::Emissive, glm::vec3(40.0f, 24.0f, 8.0f), 0, 0 };
+    scene.objects.push_back({ ObjectType::Quad, glm::vec3(0, 0.999f, 0), glm::vec3(0.25f, 0, 0.25f), ceiling_light });
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3(-0.6f, 0.2f, -0.6f), glm::vec3(0.05f), sphere_light });
+
+    scene.look_from = glm::vec3(0, 0, 3.9f);
+    scene.look_at = glm::vec3(0, 0, 0);
+    scene.vfov = 40;
+    scene.sky_horizon = glm::vec3(0);
+    scene.sky_zenith = glm::vec3(0);
+    return scene;
+}
+
+Scene CreateInstancesPreset(unsigned int seed) {
+    std::mt19937 gen(seed);
+    Scene scene;
+    Material material_ground = { MaterialType::Lambertian, glm::vec3(0.5, 0.5, 0.5), 0, 0 };
+    scene.objects.push_back({ ObjectType::Sphere, glm::vec3{0, -1000, 0}, glm::vec3(1000), material_ground });
+
+    // One coarse icosphere, stretched, turned and coloured differently by every object that places it
+    scene.meshes.push_back(CreateIcosphere(1));
+    const Material palette[] = {
+        { MaterialType::Lambertian, glm::vec3(0.8f, 0.3f, 0.2f), 0, 0 },
+        { MaterialType::Lambertian, glm::vec3(0.2f, 0.4f, 0.8f), 0, 0 },
+        { MaterialType::Lambertian, glm::vec3(0.9f, 0.8f, 0.3f), 0, 0 },
+        { MaterialType::Metal, glm::vec3(0.8f, 0.8f, 0.85f), 0.1f, 0 },
+        { MaterialType::Dielectric, glm::vec3(0), 0, 1.5f }
+    };
+    for (int a = 0; a < INSTANCE_GRID_SIZE; a++) {
+        for (int b = 0; b < INSTANCE_GRID_SIZE; b++) {
+            glm::vec3 scale(randomFloat(gen, 0.1f, 0.25f), randomFloat(gen, 0.05f, 0.15f), randomFloat(gen, 0.1f, 0.25f));
+            glm::vec3 center(0.5f * (a - INSTANCE_GRID_SIZE / 2) + randomFloat(gen, -0.1f, 0.1f), 0.2f, 0.5f * (b - INSTANCE_GRID_SIZE / 2) + randomFloat(gen, -0.1f, 0.1f));
+            Object object = { ObjectType::Mesh, center, scale, palette[std::uniform_int_distribution<int>(0, 4)(gen)] };
+            object.mesh = 0;
+            object.rotation = glm::vec3(randomFloat(gen, -180, 180), randomFloat(gen, -180, 180), randomFloat(gen, -180, 180));
+            scene.objects.push_back(object);
+        }
+    }
+
+    scene.look_from = glm::vec3(8, 3, 8);
+    scene.look_at = glm::vec3(0, 0, 0);
+    scene.vfov = 35;
+    return scene;
+}
+
+std::vector<int> FindLights(const std::vector<Object>& objects) {
+    std::vector<int> lights;
+    for (size_t i = 0; i < objects.size() && lights.size() < MAX_LIGHT_COUNT; ++i) {
+        bool sampleable = objects[i].type == ObjectType::Sphere || objects[i].type == ObjectType::Quad;
+        if (sampleable && objects[i].material.type == MaterialType::Emissive) {
+            lights.push_back(static_cast<int>(i));
+        }
+    }
+    return lights;
+}
+
+static bool ReadMaterial(std::istream& stream, Material& material) {
+    std::string type;
+    if (!(stream >> type)) {
+        return false;
+    }
+    if (type == "lambertian") {
+        material.type = MaterialType::Lambertian;
+        return static_cast<bool>(stream >> material.albedo.r >> material.albedo.g >> material.albedo.b);
+    }
+    if (type == "metal") {
+        material.type = MaterialType::Metal;
+        return static_cast<bool>(stream >> material.albedo.r >> material.albedo.g >> material.albedo.b >> material.fuzz);
+    }
+    if (type == "dielectric") {
+        material.type = MaterialType::Dielectric;
+        return static_cast<bool>(stream >> material.refraction_index);
+    }
+    if (type == "emissive") {
+        material.type = MaterialType::Emissive;
+        return static_cast<bool>(stream >> material.albedo.r >> material.albedo.g >> material.albedo.b);
+    }
+    return false;
+}
+
+bool LoadScene(const std::string& path, Scene& scene) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open scene file: " << path << std::endl;
+        return false;
+    }
+
+    scene = Scene();
+    // Every path is loaded once, objects placing the same file share the mesh
+    std::map<std::string, int> mesh_indices;
+    size_t directory_end = path.find_last_of("/\\");
+    std::string directory = directory_end == std::string::npos ? "" : path.substr(0, directory_end + 1);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        std::string keyword;
+        if (!(stream >> keyword)) {
+            continue;
+        }
+
+        bool valid = false;
+        if (keyword == "camera") {
+            valid = static_cast<bool>(stream >> scene.look_from.x >> scene.look_from.y >> scene.look_from.z
+                >> scene.look_at.x >> scene.look_at.y >> scene.look_at.z >> scene.vfov);
+        }
+        else if (keyword == "sky") {
+            valid = static_cast<bool>(stream >> scene.sky_horizon.r >> scene.sky_horizon.g >> scene.sky_horizon.b
+                >> scene.sky_zenith.r >> scene.sky_zenith.g >> scene.sky_zenith.b);
+        }
+        else if (keyword == "sphere") {
+            Object object = { ObjectType::Sphere, glm::vec3(0), glm::vec3(0), Material() };
+            float radius = 0;
+            if (stream >> object.position.x >> object.position.y >> object.position.z >> radius) {
+                object.scale = glm::vec3(radius);
+                valid = ReadMaterial(stream, object.material);
+            }
+            if (valid) {
+                scene.objects.push_back(object);
+            }
+        }
+        else if (keyword == "quad") {
+            Object object = { ObjectType::Quad, glm::vec3(0), glm::vec3(0), Material() };
+            if (stream >> object.position.x >> object.position.y >> object.position.z >> object.scale.x >> object.scale.y >> object.scale.z) {
+                // Exactly one axis has no extent, it is the one the quad faces
+                int flat_axes = (object.scale.x == 0) + (object.scale.y == 0) + (object.scale.z == 0);
+                valid = flat_axes == 1 && ReadMaterial(stream, object.material);
+            }
+            if (valid) {
+                scene.objects.push_back(object);
+            }
+        }
+        else if (keyword == "mesh") {
+            Object object = { ObjectType::Mesh, glm::vec3(0), glm::vec3(0), Material() };
+            std::string mesh_path;
+            if (stream >> mesh_path >> object.position.x >> object.position.y >> object.position.z >> object.scale.x >> object.scale.y >> object.scale.z) {
+                // The rotation is optional, a material starts with a letter
+                int next = (stream >> std::ws).peek();
+                bool has_rotation = std::isdigit(next) || next == '-' || next == '+' || next == '.';
+                valid = !has_rotation || static_cast<bool>(stream >> object.rotation.x >> object.rotation.y >> object.rotation.z);
+                valid = valid && object.scale.x != 0 && object.scale.y != 0 && object.scale.z != 0 && ReadMaterial(stream, object.material);
+            }
+            if (valid) {
+                bool absolute = mesh_path.front() == '/' || mesh_path.front() == '\\' || mesh_path.find(':') != std::string::npos;
+                std::string full_path = absolute ? mesh_path : directory + mesh_path;
+                auto found = mesh_indices.find(full_path);
+                if (found == mesh_indices.end()) {
+                    auto mesh = std::make_shared<Mesh>();
+                    valid = LoadOBJ(full_path, *mesh);
+                    if (valid) {
+                        found = mesh_indices.emplace(full_path, static_cast<int>(scene.meshes.size())).first;
+                        scene.meshes.push_back(mesh);
+                    }
+                }
+                if (valid) {
+                    object.mesh = found->second;
+                    scene.objects.push_back(object);
+                }
+            }
+        }
+
+        if (!valid) {
+            std::cerr << path << ":" << line_number << ": invalid scene entry: " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,214 @@
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/Mesh.h"
+#include "../include/SceneBuffer.h"
+
+SceneBuffer::SceneBuffer(size_t capacity) : object_buffer{ 0 }, node_buffer{ 0 }, index_buffer{ 0 }, mesh_buffers{}, mesh_textures{}, capacity{ capacity }, material_buffer{ 0 }, material_texture{ 0 }, uploaded_material_count{ 0 } {}
+
+SceneBuffer::~SceneBuffer() {
+    Release();
+}
+
+GPUObject SceneBuffer::Pack(const Object& object) {
+    GPUObject packed = {};
+    packed.position = object.position;
+    packed.type = static_cast<int>(object.type);
+    packed.scale = object.scale;
+    packed.material = FindMaterial(object.material);
+    packed.mesh_root = -1;
+    if (object.type == ObjectType::Mesh) {
+        // Like the BVH, a mesh object without a mesh is a null object
+        bool has_mesh = object.mesh >= 0 && object.mesh < static_cast<int>(mesh_roots.size()) && mesh_roots[object.mesh] >= 0;
+        glm::quat rotation = InstanceRotation(object);
+        packed.rotation = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+        packed.mesh_root = has_mesh ? mesh_roots[object.mesh] : -1;
+        packed.type = has_mesh ? packed.type : static_cast<int>(ObjectType::NullObject);
+    }
+    return packed;
+}
+
+int SceneBuffer::FindMaterial(const Material& material) {
+    auto key = std::make_tuple(static_cast<int>(material.type), material.albedo.r, material.albedo.g, material.albedo.b, material.fuzz, material.refraction_index);
+    auto found = material_indices.find(key);
+    if (found != material_indices.end()) {
+        return found->second;
+    }
+    GPUMaterial packed = {};
+    packed.albedo = material.albedo;
+    packed.type = static_cast<int>(material.type);
+    packed.fuzz = material.fuzz;
+    packed.refraction_index = material.refraction_index;
+    materials.push_back(packed);
+    material_indices.emplace(key, static_cast<int>(materials.size() - 1));
+    return static_cast<int>(materials.size() - 1);
+}
+
+void SceneBuffer::UploadMaterials() {
+    if (material_texture != 0 && uploaded_material_count == materials.size()) {
+        return;
+    }
+    UploadWhole(material_buffer, materials.data(), materials.size() * sizeof(GPUMaterial));
+    if (material_texture == 0) {
+        glGenTextures(1, &material_texture);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, material_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32I, material_buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    uploaded_material_count = materials.size();
+}
+
+void SceneBuffer::Upload(const SceneObjects& objects) {
+    // Dragging a colour slider adds a material every frame, repack once most of them are stale
+    bool compact = materials.size() > 2 * objects.Size() + 64;
+    if (object_buffer == 0 || objects.Size() > capacity || compact) {
+        // Grow geometrically and upload everything, every slot past the end is a null object
+        while (capacity < objects.Size()) {
+            capacity *= 2;
+        }
+        materials.clear();
+        material_indices.clear();
+        uploaded_material_count = 0;
+        staging.assign(capacity, GPUObject{});
+        for (size_t i = 0; i < objects.Size(); ++i) {
+            staging[i] = Pack(objects[i]);
+        }
+        UploadWhole(object_buffer, staging.data(), capacity * sizeof(GPUObject));
+        UploadMaterials();
+        return;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, object_buffer);
+    for (const auto& range : objects.GetDirtyRanges()) {
+        size_t begin = std::min(range.first, capacity);
+        size_t end = std::min(range.second, capacity);
+        if (begin >= end) {
+            continue;
+        }
+
+        // Slots past the end of the scene were removed and are cleared to null objects
+        staging.assign(end - begin, GPUObject{});
+        size_t packed_end = std::min(end, objects.Size());
+        for (size_t i = begin; i < packed_end; ++i) {
+            staging[i - begin] = Pack(objects[i]);
+        }
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, begin * sizeof(GPUObject), (end - begin) * sizeof(GPUObject), staging.data());
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    UploadMaterials();
+}
+
+void SceneBuffer::UploadBVH(const BVH& bvh) {
+    UploadWhole(node_buffer, bvh.GetNodes().data(), bvh.GetNodes().size() * sizeof(BVHNode));
+    UploadWhole(index_buffer, bvh.GetPrimitiveIndices().data(), bvh.GetPrimitiveIndices().size() * sizeof(int));
+}
+
+void SceneBuffer::UploadMeshes(const std::vector<std::shared_ptr<const Mesh>>& meshes) {
+    // Position and normal of a vertex are two RGBA32F texels, a BVHNode is two RGBA32I texels bit for bit
+    std::vector<glm::vec4> vertices;
+    std::vector<glm::uvec3> triangles;
+    std::vector<BVHNode> nodes;
+    mesh_roots.clear();
+    for (const auto& mesh : meshes) {
+        unsigned int vertex_offset = static_cast<unsigned int>(vertices.size() / 2);
+        int triangle_offset = static_cast<int>(triangles.size());
+        int node_offset = static_cast<int>(nodes.size());
+        mesh_roots.push_back(mesh->triangles.empty() ? -1 : node_offset);
+        for (size_t i = 0; i < mesh->positions.size(); ++i) {
+            vertices.push_back(glm::vec4(mesh->positions[i], 0.0f));
+            vertices.push_back(glm::vec4(mesh->normals[i], 0.0f));
+        }
+        for (const glm::uvec3& triangle : mesh->triangles) {
+            triangles.push_back(triangle + glm::uvec3(vertex_offset));
+        }
+        for (BVHNode node : mesh->bvh.GetNodes()) {
+            node.right_or_first += node.count > 0 ? triangle_offset : node_offset;
+            nodes.push_back(node);
+        }
+    }
+    UploadWhole(mesh_buffers[0], vertices.data(), vertices.size() * sizeof(glm::vec4));
+    UploadWhole(mesh_buffers[1], triangles.data(), triangles.size() * sizeof(glm::uvec3));
+    UploadWhole(mesh_buffers[2], nodes.data(), nodes.size() * sizeof(BVHNode));
+
+    const GLenum formats[] = { GL_RGBA32F, GL_RGB32I, GL_RGBA32I };
+    for (int i = 0; i < 3; ++i) {
+        if (mesh_textures[i] == 0) {
+            glGenTextures(1, &mesh_textures[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, mesh_textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], mesh_buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void SceneBuffer::UploadWhole(GLuint& buffer, const void* data, size_t size) {
+    if (buffer == 0) {
+        glGenBuffers(1, &buffer);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    if (size == 0) {
+        // Empty storage buffers are not bindable everywhere, keep one zeroed element
+        const int empty[8] = {};
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(empty), empty, GL_DYNAMIC_DRAW);
+    }
+    else {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void SceneBuffer::Bind() const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, object_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_NODE_BUFFER_BINDING, node_buffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BVH_INDEX_BUFFER_BINDING, index_buffer);
+    const GLenum units[] = { MESH_VERTEX_TEXTURE_UNIT, MESH_TRIANGLE_TEXTURE_UNIT, MESH_NODE_TEXTURE_UNIT };
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + units[i]);
+        glBindTexture(GL_TEXTURE_BUFFER, mesh_textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0 + MATERIAL_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, material_texture);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SceneBuffer::Release() {
+    GLuint buffers[] = { object_buffer, node_buffer, index_buffer, mesh_buffers[0], mesh_buffers[1], mesh_buffers[2], material_buffer };
+    for (GLuint buffer : buffers) {
+        if (buffer != 0) {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+    for (GLuint& texture : mesh_textures) {
+        if (texture != 0) {
+            glDeleteTextures(1, &texture);
+        }
+        texture = 0;
+    }
+    if (material_texture != 0) {
+        glDeleteTextures(1, &material_texture);
+    }
+    object_buffer = 0;
+    node_buffer = 0;
+    index_buffer = 0;
+    for (GLuint& buffer : mesh_buffers) {
+        buffer = 0;
+    }
+    material_buffer = 0;
+    material_texture = 0;
+    mesh_roots.clear();
+    materials.clear();
+    material_indices.clear();
+    uploaded_material_count = 0;
+}
+
+//Getters
+int SceneBuffer::GetLiveObjectCount() const {
+    int count = (object_buffer != 0) + (node_buffer != 0) + (index_buffer != 0);
+    for (int i = 0; i < 3; ++i) {
+        count += (mesh_buffers[i] != 0) + (mesh_textures[i] != 0);
+    }
+    count += (material_buffer != 0) + (material_texture != 0);
+    return count;
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "../include/SceneObjects.h"
+
+SceneObjects::SceneObjects() {}
+
+Object& SceneObjects::operator[](size_t index) {
+    return objects[index];
+}
+
+const Object& SceneObjects::operator[](size_t index) const {
+    return objects[index];
+}
+
+void SceneObjects::Add(const Object& object) {
+    objects.push_back(object);
+    MarkDirty(objects.size() - 1);
+}
+
+void SceneObjects::Set(size_t index, const Object& object) {
+    objects[index] = object;
+    MarkDirty(index);
+}
+
+void SceneObjects::Remove(size_t index) {
+    // Everything after the removed object shifts down and the old last slot is left empty
+    size_t old_size = objects.size();
+    objects.erase(objects.begin() + index);
+    MarkDirty(index, old_size);
+}
+
+void SceneObjects::Clear() {
+    MarkDirty(0, objects.size());
+    objects.clear();
+}
+
+void SceneObjects::MarkDirty(size_t index) {
+    MarkDirty(index, index + 1);
+}
+
+void SceneObjects::MarkDirty(size_t begin, size_t end) {
+    if (begin >= end) {
+        return;
+    }
+    // Insert in order, then merge every range that overlaps or touches the new one
+    auto it = std::lower_bound(dirty_ranges.begin(), dirty_ranges.end(), std::make_pair(begin, end));
+    it = dirty_ranges.insert(it, { begin, end });
+    if (it != dirty_ranges.begin() && std::prev(it)->second >= it->first) {
+        --it;
+        it->second = std::max(it->second, std::next(it)->second);
+        dirty_ranges.erase(std::next(it));
+    }
+    while (std::next(it) != dirty_ranges.end() && std::next(it)->first <= it->second) {
+        it->second = std::max(it->second, std::next(it)->second);
+        dirty_ranges.erase(std::next(it));
+    }
+}
+
+void SceneObjects::ClearDirty() {
+    dirty_ranges.clear();
+}
+
+//Getters
+size_t SceneObjects::Size() const {
+    return objects.size();
+}
+
+bool SceneObjects::IsDirty() const {
+    return !dirty_ranges.empty();
+}
+
+const std::vector<Object>& SceneObjects::GetObjects() const {
+    return objects;
+}
+
+const std::vector<std::pair<size_t, size_t>>& SceneObjects::GetDirtyRanges() const {
+    return dirty_ranges;
+}
@@ -19,14 +19,7 @@ Shader::Shader(const char* vertex_file_path, const char* fragment_file_path) {
 
     // Read the Vertex Shader code from the file
     std::string VertexShaderCode;
-    std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-    if (VertexShaderStream.is_open()) {
-        std::stringstream sstr;
-        sstr << VertexShaderStream.rdbuf();
-        VertexShaderCode = sstr.str();
-        VertexShaderStream.close();
-    }
-    else {
+    if (!ReadSource(vertex_file_path, VertexShaderCode)) {
         std::cerr << "Could not open vertex shader file: " << vertex_file_path << std::endl;
         id = 0;
         return;
@@ -34,15 +27,8 @@ Shader::Shader(const char* vertex_file_path, const char* fragment_file_path) {
 
     // Read the Fragment Shader code from the file
     std::string FragmentShaderCode;
-    std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-    if (FragmentShaderStream.is_open()) {
-        std::stringstream sstr;
-        sstr << FragmentShaderStream.rdbuf();
-        FragmentShaderCode = sstr.str();
-        FragmentShaderStream.close();
-    }
-    else {
-        std::cerr << "Could not open fragment shader file: " << vertex_file_path << std::endl;
+    if (!ReadSource(fragment_file_path, FragmentShaderCode)) {
+        std::cerr << "Could not open fragment shader file: " << fragment_file_path << std::endl;
         id = 0;
         return;
     }
@@ -52,14 +38,14 @@ Shader::Shader(const char* vertex_file_path, const char* fragment_file_path) {
     char const* VertexSourcePointer = VertexShaderCode.c_str();
     glShaderSource(VertexShaderID, 1, &VertexSourcePointer, NULL);
     glCompileShader(VertexShaderID);
-    CheckCompileErrors(id, "VERTEX");
+    CheckCompileErrors(VertexShaderID, "VERTEX");
 
     // Compile Fragment Shader
     printf("Compiling shader : %s\n", fragment_file_path);
     char const* FragmentSourcePointer = FragmentShaderCode.c_str();
     glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer, NULL);
     glCompileShader(FragmentShaderID);
-    CheckCompileErrors(id, "FRAGMENT");
+    CheckCompileErrors(FragmentShaderID, "FRAGMENT");
 
     // Shader Program
     printf("Linking program\n");
@@ -73,11 +59,70 @@ Shader::Shader(const char* vertex_file_path, const char* fragment_file_path) {
     glDeleteShader(FragmentShaderID);
 }
 
+Shader::Shader(const char* compute_file_path) {
+    // Read the Compute Shader code from the file
+    std::string ComputeShaderCode;
+    if (!ReadSource(compute_file_path, ComputeShaderCode)) {
+        std::cerr << "Could not open compute shader file: " << compute_file_path << std::endl;
+        id = 0;
+        return;
+    }
+
+    // Compile Compute Shader
+    printf("Compiling shader : %s\n", compute_file_path);
+    GLuint ComputeShaderID = glCreateShader(GL_COMPUTE_SHADER);
+    char const* ComputeSourcePointer = ComputeShaderCode.c_str();
+    glShaderSource(ComputeShaderID, 1, &ComputeSourcePointer, NULL);
+    glCompileShader(ComputeShaderID);
+    CheckCompileErrors(ComputeShaderID, "COMPUTE");
+
+    // Shader Program
+    printf("Linking program\n");
+    id = glCreateProgram();
+    glAttachShader(id, ComputeShaderID);
+    glLinkProgram(id);
+    CheckCompileErrors(id, "PROGRAM");
+
+    glDeleteShader(ComputeShaderID);
+}
+
 // Destructor to clean up shader program
 Shader::~Shader() {
     glDeleteProgram(id);
 }
 
+// Reads a shader file and replaces every #include "file" line with that file, relative to the including one
+bool Shader::ReadSource(const std::string& path, std::string& source, int depth) {
+    std::ifstream stream(path, std::ios::in);
+    if (!stream.is_open() || depth > MAX_INCLUDE_DEPTH) {
+        return false;
+    }
+    std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+
+    std::stringstream sstr;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(stream, line)) {
+        ++line_number;
+        size_t start = line.find("#include");
+        if (start == std::string::npos || line.find_first_not_of(" \t") != start) {
+            sstr << line << "\n";
+            continue;
+        }
+        size_t open = line.find('"', start);
+        size_t close = line.find('"', open + 1);
+        std::string included;
+        if (open == std::string::npos || close == std::string::npos || !ReadSource(directory + line.substr(open + 1, close - open - 1), included, depth + 1)) {
+            std::cerr << path << ":" << line_number << ": could not include " << line << std::endl;
+            return false;
+        }
+        // Keep the line numbers of compile errors pointing at the including file
+        sstr << included << "#line " << line_number + 1 << "\n";
+    }
+    source = sstr.str();
+    return true;
+}
+
 // Utility function for checking shader compilation and linking errors
 void Shader::CheckCompileErrors(unsigned int shader, const std::string& type) {
     int success;
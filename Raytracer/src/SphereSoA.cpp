@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../include/SphereSoA.h"
+
+#if SPHERE_LANES > 1
+#include <immintrin.h>
+#endif
+
+void SphereSoA::Build(const std::vector<Object>& objects, const BVH& bvh) {
+    const std::vector<int>& primitive_indices = bvh.GetPrimitiveIndices();
+    size_t size = primitive_indices.size() + SPHERE_LANES;
+    x.assign(size, 0.0f);
+    y.assign(size, 0.0f);
+    z.assign(size, 0.0f);
+    radius.assign(size, std::numeric_limits<float>::quiet_NaN());
+    for (size_t i = 0; i < primitive_indices.size(); ++i) {
+        const Object& object = objects[primitive_indices[i]];
+        if (object.type == ObjectType::Sphere) {
+            x[i] = object.position.x;
+            y[i] = object.position.y;
+            z[i] = object.position.z;
+            radius[i] = object.scale.x;
+        }
+    }
+
+    // Children come after their parent, so going backwards finds both children before the parent. The objects of a
+    // subtree are the range from its leftmost leaf, and -1 marks a subtree that cannot be a batch
+    const std::vector<BVHNode>& nodes = bvh.GetNodes();
+    batches.assign(nodes.size(), glm::ivec2(0));
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+        const BVHNode& node = nodes[i];
+        if (node.count > 0) {
+            bool all_spheres = true;
+            for (int j = node.right_or_first; j < node.right_or_first + node.count; ++j) {
+                all_spheres = all_spheres && objects[primitive_indices[j]].type == ObjectType::Sphere;
+            }
+            batches[i] = glm::ivec2(node.right_or_first, all_spheres ? node.count : -1);
+        }
+        else {
+            const glm::ivec2& left = batches[i + 1];
+            const glm::ivec2& right = batches[node.right_or_first];
+            bool batch = left.y >= 0 && right.y >= 0 && left.y + right.y <= SPHERE_BATCH_SIZE;
+            batches[i] = glm::ivec2(left.x, batch ? left.y + right.y : -1);
+        }
+    }
+    for (glm::ivec2& batch : batches) {
+        batch.y = batch.y <= SPHERE_BATCH_SIZE ? std::max(batch.y, 0) : 0;
+    }
+}
+
+void HitSpheresScalar(const SphereSoA& spheres, int first, int count, const glm::vec3& origin, const glm::vec3& direction, float t_min, float t_max, float* t) {
+    float a = glm::dot(direction, direction);
+    for (int i = 0; i < count; ++i) {
+        int slot = first + i;
+        glm::vec3 oc = origin - glm::vec3(spheres.x[slot], spheres.y[slot], spheres.z[slot]);
+        float half_b = glm::dot(oc, direction);
+        float c = glm::dot(oc, oc) - spheres.radius[slot] * spheres.radius[slot];
+        float discriminant = half_b * half_b - a * c;
+        t[i] = INFINITY;
+        if (discriminant >= 0) {
+            float root = (-half_b - std::sqrt(discriminant)) / a;
+            if (t_min < root && root < t_max) {
+                t[i] = root;
+                continue;
+            }
+            root = (-half_b + std::sqrt(discriminant)) / a;
+            if (t_min < root && root < t_max) {
+                t[i] = root;
+            }
+        }
+    }
+}
+
+#if SPHERE_LANES > 1
+// The few operations the kernel needs, on whichever register is SPHERE_LANES floats wide
+namespace {
+#if SPHERE_LANES == 8
+typedef __m256 Lanes;
+inline Lanes Load(const float* p) { return _mm256_loadu_ps(p); }
+inline void Store(float* p, Lanes a) { _mm256_storeu_ps(p, a); }
+inline Lanes Set(float value) { return _mm256_set1_ps(value); }
+inline Lanes Add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes Div(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+inline Lanes Sqrt(Lanes a) { return _mm256_sqrt_ps(a); }
+inline Lanes Negate(Lanes a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+inline Lanes And(Lanes a, Lanes b) { return _mm256_and_ps(a, b); }
+inline Lanes LessThan(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline bool AnyNotNegative(Lanes a) { return _mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ)) != 0; }
+inline Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+#else
+typedef __m128 Lanes;
+inline Lanes Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, Lanes a) { _mm_storeu_ps(p, a); }
+inline Lanes Set(float value) { return _mm_set1_ps(value); }
+inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes Div(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+inline Lanes Sqrt(Lanes a) { return _mm_sqrt_ps(a); }
+inline Lanes Negate(Lanes a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline Lanes And(Lanes a, Lanes b) { return _mm_and_ps(a, b); }
+inline Lanes LessThan(Lanes a, Lanes b) { return _mm_cmplt_ps(a, b); }
+inline bool AnyNotNegative(Lanes a) { return _mm_movemask_ps(_mm_cmpge_ps(a, _mm_setzero_ps())) != 0; }
+inline Lanes Select(Lanes mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+}
+
+void HitSpheres(const SphereSoA& spheres, int first, int count, const glm::vec3& origin, const glm::vec3& direction, float t_min, float t_max, float* t) {
+    // Every product and sum in the order of hitSphere, and nothing fused, so each lane rounds like the scalar code
+    float a_scalar = glm::dot(direction, direction);
+    Lanes a = Set(a_scalar);
+    Lanes dx = Set(direction.x), dy = Set(direction.y), dz = Set(direction.z);
+    Lanes lower = Set(t_min), upper = Set(t_max);
+    Lanes miss = Set(INFINITY);
+    for (int i = 0; i < count; i += SPHERE_LANES) {
+        int slot = first + i;
+        Lanes ocx = Sub(Set(origin.x), Load(&spheres.x[slot]));
+        Lanes ocy = Sub(Set(origin.y), Load(&spheres.y[slot]));
+        Lanes ocz = Sub(Set(origin.z), Load(&spheres.z[slot]));
+        Lanes radius = Load(&spheres.radius[slot]);
+        Lanes half_b = Add(Add(Mul(ocx, dx), Mul(ocy, dy)), Mul(ocz, dz));
+        Lanes c = Sub(Add(Add(Mul(ocx, ocx), Mul(ocy, ocy)), Mul(ocz, ocz)), Mul(radius, radius));
+        Lanes discriminant = Sub(Mul(half_b, half_b), Mul(a, c));
+        // Most rays miss most spheres, which skips the square root and divisions for all lanes at once
+        Lanes result = miss;
+        if (AnyNotNegative(discriminant)) {
+            Lanes root_of_discriminant = Sqrt(discriminant);
+            Lanes near_root = Div(Sub(Negate(half_b), root_of_discriminant), a);
+            Lanes far_root = Div(Add(Negate(half_b), root_of_discriminant), a);
+            Lanes near_inside = And(LessThan(lower, near_root), LessThan(near_root, upper));
+            Lanes far_inside = And(LessThan(lower, far_root), LessThan(far_root, upper));
+            // A negative or NaN discriminant makes both roots NaN, which are never inside
+            result = Select(near_inside, near_root, Select(far_inside, far_root, miss));
+        }
+
+        if (i + SPHERE_LANES <= count) {
+            Store(t + i, result);
+            continue;
+        }
+        float lanes[SPHERE_LANES];
+        Store(lanes, result);
+        for (int lane = 0; i + lane < count; ++lane) {
+            t[i + lane] = lanes[lane];
+        }
+    }
+}
+#else
+void HitSpheres(const SphereSoA& spheres, int first, int count, const glm::vec3& origin, const glm::vec3& direction, float t_min, float t_max, float* t) {
+    HitSpheresScalar(spheres, first, count, origin, direction, t_min, t_max, t);
+}
+#endif
@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "../include/TileScheduler.h"
+
+// Interleaves the bits of x and y, so tiles close on the curve are close in the image
+static uint32_t MortonCode(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t value) {
+        value &= 0xffff;
+        value = (value | (value << 8)) & 0x00ff00ff;
+        value = (value | (value << 4)) & 0x0f0f0f0f;
+        value = (value | (value << 2)) & 0x33333333;
+        value = (value | (value << 1)) & 0x55555555;
+        return value;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+TileScheduler::TileScheduler(int thread_count, int tile_size)
+    : thread_count{ thread_count }, tile_size{ std::max(1, tile_size) }, stolen_tiles{ 0 } {
+    if (this->thread_count <= 0) {
+        this->thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < this->thread_count; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+}
+
+void TileScheduler::Run(int width, int height, const std::function<void(const Tile&)>& render_tile) {
+    int tiles_x = (width + tile_size - 1) / tile_size;
+    int tiles_y = (height + tile_size - 1) / tile_size;
+    std::vector<int> order(static_cast<size_t>(tiles_x) * tiles_y);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [tiles_x](int a, int b) {
+        return MortonCode(a % tiles_x, a / tiles_x) < MortonCode(b % tiles_x, b / tiles_x);
+    });
+    for (int i = 0; i < thread_count; ++i) {
+        size_t begin = order.size() * i / thread_count;
+        size_t end = order.size() * (i + 1) / thread_count;
+        queues[i]->tiles.assign(order.begin() + begin, order.begin() + end);
+    }
+    stolen_tiles = 0;
+
+    auto worker = [&](int thread) {
+        Queue& queue = *queues[thread];
+        while (true) {
+            int tile = -1;
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (!queue.tiles.empty()) {
+                    tile = queue.tiles.front();
+                    queue.tiles.pop_front();
+                }
+            }
+            if (tile < 0) {
+                if (!Steal(thread)) {
+                    return;
+                }
+                continue;
+            }
+            glm::ivec2 corner(tile % tiles_x, tile / tiles_x);
+            render_tile(Tile{ corner * tile_size, glm::min((corner + 1) * tile_size, glm::ivec2(width, height)) });
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+bool TileScheduler::Steal(int thread) {
+    while (true) {
+        int victim = -1;
+        size_t most = 0;
+        for (int i = 0; i < thread_count; ++i) {
+            if (i == thread) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(queues[i]->mutex);
+            if (queues[i]->tiles.size() > most) {
+                most = queues[i]->tiles.size();
+                victim = i;
+            }
+        }
+        // Tiles are never added during a run, so a thread that finds nothing left can stop. Tiles moving between two
+        // queues are already owned by the thief, which renders them
+        if (victim < 0) {
+            return false;
+        }
+
+        // The victim may have taken tiles since it was looked at, so it is checked again under its lock
+        std::vector<int> taken;
+        {
+            Queue& queue = *queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            size_t count = (queue.tiles.size() + 1) / 2;
+            taken.assign(queue.tiles.end() - count, queue.tiles.end());
+            queue.tiles.erase(queue.tiles.end() - count, queue.tiles.end());
+        }
+        if (taken.empty()) {
+            continue;
+        }
+        stolen_tiles += static_cast<int>(taken.size());
+        Queue& queue = *queues[thread];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tiles.insert(queue.tiles.end(), taken.begin(), taken.end());
+        return true;
+    }
+}
+
+//Getters
+int TileScheduler::GetThreadCount() const {
+    return thread_count;
+}
+
+int TileScheduler::GetTileSize() const {
+    return tile_size;
+}
+
+int TileScheduler::GetStolenTiles() const {
+    return stolen_tiles;
+}
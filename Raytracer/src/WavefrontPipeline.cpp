@@ -0,0 +1,273 @@
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <string>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../include/WavefrontPipeline.h"
+#include "../include/BlueNoise.h"
+
+WavefrontPipeline::WavefrontPipeline() : path_capacity{ 0 }, sky_horizon{ 1.0f }, sky_zenith{ 0.5f, 0.7f, 1.0f }, sort_rays{ false }, count_coherence{ false } {}
+
+WavefrontPipeline::~WavefrontPipeline() {
+    Release();
+}
+
+void WavefrontPipeline::SetupShaders() {
+    shaders["generate"] = std::make_unique<Shader>("shaders/wavefront_generate.cs.glsl");
+    GLuint generate = shaders["generate"]->GetId();
+    uniform_locations["generate_path_count"] = glGetUniformLocation(generate, "u_pathCount");
+    uniform_locations["generate_pixel00"] = glGetUniformLocation(generate, "u_pixel00");
+    uniform_locations["generate_pixel_delta_u"] = glGetUniformLocation(generate, "u_pixelDeltaU");
+    uniform_locations["generate_pixel_delta_v"] = glGetUniformLocation(generate, "u_pixelDeltaV");
+    uniform_locations["generate_camera_center"] = glGetUniformLocation(generate, "u_cameraCenter");
+    uniform_locations["generate_width"] = glGetUniformLocation(generate, "u_width");
+    uniform_locations["generate_frame"] = glGetUniformLocation(generate, "u_frame");
+    uniform_locations["generate_sample_offset"] = glGetUniformLocation(generate, "u_sampleOffset");
+    uniform_locations["generate_sample_index"] = glGetUniformLocation(generate, "u_sampleIndex");
+    uniform_locations["generate_ray_queue"] = glGetUniformLocation(generate, "u_rayQueue");
+    uniform_locations["generate_sampler"] = glGetUniformLocation(generate, "u_sampler");
+    uniform_locations["generate_blue_noise"] = glGetUniformLocation(generate, "u_blueNoise");
+
+    shaders["intersect"] = std::make_unique<Shader>("shaders/wavefront_intersect.cs.glsl");
+    GLuint intersect = shaders["intersect"]->GetId();
+    uniform_locations["intersect_path_count"] = glGetUniformLocation(intersect, "u_pathCount");
+    uniform_locations["intersect_object_count"] = glGetUniformLocation(intersect, "u_objectCount");
+    uniform_locations["intersect_ray_queue"] = glGetUniformLocation(intersect, "u_rayQueue");
+    uniform_locations["intersect_sky_horizon"] = glGetUniformLocation(intersect, "u_skyHorizon");
+    uniform_locations["intersect_sky_zenith"] = glGetUniformLocation(intersect, "u_skyZenith");
+    uniform_locations["intersect_light_count"] = glGetUniformLocation(intersect, "u_lightCount");
+    uniform_locations["intersect_lights"] = glGetUniformLocation(intersect, "u_lights");
+    uniform_locations["intersect_count_coherence"] = glGetUniformLocation(intersect, "u_countCoherence");
+
+    shaders["shade"] = std::make_unique<Shader>("shaders/wavefront_shade.cs.glsl");
+    GLuint shade = shaders["shade"]->GetId();
+    uniform_locations["shade_path_count"] = glGetUniformLocation(shade, "u_pathCount");
+    uniform_locations["shade_material_queue"] = glGetUniformLocation(shade, "u_materialQueue");
+    uniform_locations["shade_light_bounces"] = glGetUniformLocation(shade, "u_lightBounces");
+    uniform_locations["shade_roulette_depth"] = glGetUniformLocation(shade, "u_rouletteDepth");
+    uniform_locations["shade_ray_queue"] = glGetUniformLocation(shade, "u_rayQueue");
+    uniform_locations["shade_width"] = glGetUniformLocation(shade, "u_width");
+    uniform_locations["shade_frame"] = glGetUniformLocation(shade, "u_frame");
+    uniform_locations["shade_sample_offset"] = glGetUniformLocation(shade, "u_sampleOffset");
+    uniform_locations["shade_sample_index"] = glGetUniformLocation(shade, "u_sampleIndex");
+    uniform_locations["shade_sampler"] = glGetUniformLocation(shade, "u_sampler");
+    uniform_locations["shade_blue_noise"] = glGetUniformLocation(shade, "u_blueNoise");
+    uniform_locations["shade_object_count"] = glGetUniformLocation(shade, "u_objectCount");
+    uniform_locations["shade_light_count"] = glGetUniformLocation(shade, "u_lightCount");
+    uniform_locations["shade_lights"] = glGetUniformLocation(shade, "u_lights");
+    uniform_locations["shade_sort_rays"] = glGetUniformLocation(shade, "u_sortRays");
+
+    shaders["sort"] = std::make_unique<Shader>("shaders/wavefront_sort.cs.glsl");
+    GLuint sort = shaders["sort"]->GetId();
+    uniform_locations["sort_path_count"] = glGetUniformLocation(sort, "u_pathCount");
+    uniform_locations["sort_ray_queue"] = glGetUniformLocation(sort, "u_rayQueue");
+
+    shaders["prepare"] = std::make_unique<Shader>("shaders/wavefront_prepare.cs.glsl");
+    GLuint prepare = shaders["prepare"]->GetId();
+    uniform_locations["prepare_path_count"] = glGetUniformLocation(prepare, "u_pathCount");
+    uniform_locations["prepare_stage"] = glGetUniformLocation(prepare, "u_stage");
+
+    shaders["resolve"] = std::make_unique<Shader>("shaders/raytracing.vs.glsl", "shaders/wavefront_resolve.fs.glsl");
+    GLuint resolve = shaders["resolve"]->GetId();
+    uniform_locations["resolve_width"] = glGetUniformLocation(resolve, "u_width");
+    uniform_locations["resolve_samples_per_pixel"] = glGetUniformLocation(resolve, "u_samplesPerPixel");
+    uniform_locations["resolve_blend_weight"] = glGetUniformLocation(resolve, "u_blendWeight");
+}
+
+void WavefrontPipeline::Resize(int path_count) {
+    if (path_count <= path_capacity) {
+        return;
+    }
+    // Only grows, a smaller resolution uses the front of the buffers
+    path_capacity = path_count;
+    const std::pair<const char*, size_t> sizes[] = {
+        { "paths", sizeof(WavefrontPath) },
+        { "radiance", sizeof(glm::vec4) },
+        { "queues", WAVEFRONT_QUEUE_COUNT * sizeof(GLint) }
+    };
+    for (const auto& size : sizes) {
+        GLuint& buffer = buffers[size.first];
+        if (buffer == 0) {
+            glGenBuffers(1, &buffer);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, path_capacity * size.second, nullptr, GL_DYNAMIC_COPY);
+    }
+
+    GLuint& queue_state = buffers["queue_state"];
+    if (queue_state == 0) {
+        const WavefrontQueueState state = {};
+        glGenBuffers(1, &queue_state);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, queue_state);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(state), &state, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void WavefrontPipeline::Prepare(int stage) {
+    shaders["prepare"]->Use();
+    glUniform1i(uniform_locations["prepare_stage"], stage);
+    glDispatchCompute(1, 1, 1);
+    // The next kernel reads the queue lengths, and its dispatch size comes from the same buffer
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void WavefrontPipeline::Trace(const Camera& camera, int width, int height, int samples, int sample_offset, unsigned int frame, int light_bounces, int roulette_depth, int object_count, SamplerType sampler) {
+    if (shaders.empty()) {
+        SetupShaders();
+    }
+    int path_count = width * height;
+    Resize(path_count);
+    GLuint path_groups = (path_count + WAVEFRONT_GROUP_SIZE - 1) / WAVEFRONT_GROUP_SIZE;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WAVEFRONT_PATH_BUFFER_BINDING, buffers["paths"]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WAVEFRONT_RADIANCE_BUFFER_BINDING, buffers["radiance"]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WAVEFRONT_QUEUE_BUFFER_BINDING, buffers["queues"]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WAVEFRONT_QUEUE_STATE_BINDING, buffers["queue_state"]);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffers["queue_state"]);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers["radiance"]);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32F, GL_RED, GL_FLOAT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Uniforms that stay the same for every wave
+    shaders["generate"]->Use();
+    glUniform1i(uniform_locations["generate_path_count"], path_count);
+    glUniform3fv(uniform_locations["generate_pixel00"], 1, glm::value_ptr(camera.pixel00_loc));
+    glUniform3fv(uniform_locations["generate_pixel_delta_u"], 1, glm::value_ptr(camera.pixel_delta_u));
+    glUniform3fv(uniform_locations["generate_pixel_delta_v"], 1, glm::value_ptr(camera.pixel_delta_v));
+    glUniform3fv(uniform_locations["generate_camera_center"], 1, glm::value_ptr(camera.camera_center));
+    glUniform1i(uniform_locations["generate_width"], width);
+    glUniform1ui(uniform_locations["generate_frame"], frame);
+    glUniform1i(uniform_locations["generate_sample_offset"], sample_offset);
+    glUniform1i(uniform_locations["generate_ray_queue"], 0);
+    glUniform1i(uniform_locations["generate_sampler"], static_cast<int>(sampler));
+    glUniform1i(uniform_locations["generate_blue_noise"], BLUE_NOISE_TEXTURE_UNIT);
+    shaders["intersect"]->Use();
+    glUniform1i(uniform_locations["intersect_path_count"], path_count);
+    glUniform1i(uniform_locations["intersect_object_count"], object_count);
+    glUniform3fv(uniform_locations["intersect_sky_horizon"], 1, glm::value_ptr(sky_horizon));
+    glUniform3fv(uniform_locations["intersect_sky_zenith"], 1, glm::value_ptr(sky_zenith));
+    glUniform1i(uniform_locations["intersect_light_count"], static_cast<int>(lights.size()));
+    glUniform1iv(uniform_locations["intersect_lights"], static_cast<GLsizei>(lights.size()), lights.data());
+    glUniform1i(uniform_locations["intersect_count_coherence"], count_coherence);
+    shaders["shade"]->Use();
+    glUniform1i(uniform_locations["shade_path_count"], path_count);
+    glUniform1i(uniform_locations["shade_light_bounces"], light_bounces);
+    glUniform1i(uniform_locations["shade_roulette_depth"], roulette_depth);
+    glUniform1i(uniform_locations["shade_width"], width);
+    glUniform1ui(uniform_locations["shade_frame"], frame);
+    glUniform1i(uniform_locations["shade_sample_offset"], sample_offset);
+    glUniform1i(uniform_locations["shade_sampler"], static_cast<int>(sampler));
+    glUniform1i(uniform_locations["shade_blue_noise"], BLUE_NOISE_TEXTURE_UNIT);
+    glUniform1i(uniform_locations["shade_object_count"], object_count);
+    glUniform1i(uniform_locations["shade_light_count"], static_cast<int>(lights.size()));
+    glUniform1iv(uniform_locations["shade_lights"], static_cast<GLsizei>(lights.size()), lights.data());
+    glUniform1i(uniform_locations["shade_sort_rays"], sort_rays);
+    shaders["sort"]->Use();
+    glUniform1i(uniform_locations["sort_path_count"], path_count);
+    shaders["prepare"]->Use();
+    glUniform1i(uniform_locations["prepare_path_count"], path_count);
+
+    for (int sample = 0; sample < samples; ++sample) {
+        Prepare(0);
+        shaders["generate"]->Use();
+        glUniform1i(uniform_locations["generate_sample_index"], sample);
+        glDispatchCompute(path_groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        for (int bounce = 0; bounce < light_bounces; ++bounce) {
+            // The ray queues swap roles every bounce, the rays queued by shading are intersected next
+            int ray_queue = bounce % 2;
+
+            // Once every path has ended the queues are empty and these dispatch no groups
+            shaders["intersect"]->Use();
+            glUniform1i(uniform_locations["intersect_ray_queue"], ray_queue);
+            glDispatchComputeIndirect(0);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            Prepare(1);
+
+            shaders["shade"]->Use();
+            glUniform1i(uniform_locations["shade_ray_queue"], ray_queue);
+            glUniform1i(uniform_locations["shade_sample_index"], sample);
+            for (int queue = 0; queue < WAVEFRONT_MATERIAL_QUEUES; ++queue) {
+                glUniform1i(uniform_locations["shade_material_queue"], queue);
+                glDispatchComputeIndirect((1 + queue) * sizeof(WavefrontQueueState::dispatch[0]));
+            }
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            Prepare(2);
+
+            if (sort_rays) {
+                shaders["sort"]->Use();
+                glUniform1i(uniform_locations["sort_ray_queue"], 1 - ray_queue);
+                glDispatchComputeIndirect(0);
+                glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            }
+        }
+    }
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
+
+void WavefrontPipeline::Resolve(int width, int samples, float blend_weight, GLuint quad_vao) {
+    shaders["resolve"]->Use();
+    glUniform1i(uniform_locations["resolve_width"], width);
+    glUniform1i(uniform_locations["resolve_samples_per_pixel"], samples);
+    glUniform1f(uniform_locations["resolve_blend_weight"], blend_weight);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, WAVEFRONT_RADIANCE_BUFFER_BINDING, buffers["radiance"]);
+
+    glBindVertexArray(quad_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+}
+
+void WavefrontPipeline::Release() {
+    for (auto& entry : buffers) {
+        if (entry.second != 0) {
+            glDeleteBuffers(1, &entry.second);
+        }
+    }
+    buffers.clear();
+    shaders.clear();
+    uniform_locations.clear();
+    path_capacity = 0;
+}
+
+void WavefrontPipeline::SetSky(const glm::vec3& horizon, const glm::vec3& zenith) {
+    sky_horizon = horizon;
+    sky_zenith = zenith;
+}
+
+void WavefrontPipeline::SetLights(const std::vector<int>& light_objects) {
+    lights = light_objects;
+}
+
+void WavefrontPipeline::SetRaySorting(bool sort) {
+    sort_rays = sort;
+}
+
+void WavefrontPipeline::SetCoherenceCounting(bool count) {
+    count_coherence = count;
+}
+
+void WavefrontPipeline::ReadCoherence(unsigned long long& rays, unsigned long long& coherent_rays) {
+    GLuint counts[2] = {};
+    if (buffers["queue_state"] != 0) {
+        const GLuint no_rays[2] = {};
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers["queue_state"]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offsetof(WavefrontQueueState, intersected_rays), sizeof(counts), counts);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, offsetof(WavefrontQueueState, intersected_rays), sizeof(no_rays), no_rays);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    rays = counts[0];
+    coherent_rays = counts[1];
+}
+
+//Getters
+int WavefrontPipeline::GetLiveObjectCount() const {
+    return static_cast<int>(buffers.size());
+}
@@ -16,6 +16,10 @@ WindowManager::WindowManager(int width, int height, const char* title, bool full
         cerr << "Failed to initialize GLFW" << endl;
         exit(EXIT_FAILURE);
     }
+    // The scene is read from a shader storage buffer, which needs OpenGL 4.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
     if (fullscreen) {
         window = glfwCreateWindow(video_mode->width, video_mode->height, title, glfwGetPrimaryMonitor(), nullptr);
@@ -29,8 +33,6 @@ WindowManager::WindowManager(int width, int height, const char* title, bool full
         exit(EXIT_FAILURE);
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwMakeContextCurrent(window);
     glfwSetWindowUserPointer(window, this);
     glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
@@ -48,6 +50,8 @@ WindowManager::WindowManager(int width, int height, const char* title, bool full
 
 WindowManager::~WindowManager() {
     cout << "destroying window" << endl;
+    // The renderer frees its GL objects, so it has to go before the context does
+    renderer.reset();
     glfwDestroyWindow(window);
     glfwTerminate();
 }